@@ -0,0 +1,36 @@
+/**
+  ******************************************************************************
+  * @file           : adpcm.h
+  * @brief          : IMA-ADPCM block codec for compressed samples
+  ******************************************************************************
+  *
+  * Block layout (ADPCM_BLOCK_BYTES): int16 predictor (little endian),
+  * uint8 step index, one pad byte, then ADPCM_BLOCK_FRAMES 4-bit codes,
+  * low nibble first. Every block starts from its own header, so any block
+  * can be decoded on its own - loops and retriggers need no history.
+  *
+  */
+
+#ifndef __ADPCM_H
+#define __ADPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define ADPCM_BLOCK_FRAMES     128
+#define ADPCM_BLOCK_BYTES      (4 + ADPCM_BLOCK_FRAMES / 2)
+
+/* Exported functions --------------------------------------------------------*/
+void ADPCM_DecodeBlock(const uint8_t *block, int16_t *out);
+void ADPCM_EncodeBlock(const int16_t *in, uint32_t frames, uint8_t *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADPCM_H */
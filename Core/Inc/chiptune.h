@@ -14,15 +14,188 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
+#include "profile.h"
 #include <stdint.h>
 
 /* Exported constants --------------------------------------------------------*/
 #define AUDIO_BUFFER_SIZE       512
 #define DMA_BUFFER_SIZE        256
+#define AUDIO_WRITE_LEAD       16     /* frames the audio interrupt mixes ahead of the I2S DMA */
 #define CHIPTUNE_CHANNELS      4
 #define TRACKLEN               32
-#define SONGLEN                0x37
-#define MAXTRACK               0x92
+#define SONG_MAX_ORDERS        64     /* order positions per song */
+#define SONG_MAX_TRACKS        0x92   /* tracks per song */
+#define SONG_MAX_INSTRUMENTS   15
+#define TICKS_PER_ROW          5      /* song start speed, see CHIPTUNE_EV_SPEED */
+#define SONG_NO_LOOP           0xFF
+#define SONG_EXTERNAL          0xFE   /* Chiptune_GetSong() of a Chiptune_PlaySong() song */
+
+/* Track and instrument commands by number; track rows use 1-15, 0 = none,
+ * so the filter's 'c' and 'q' (16 and 17) only run from instruments.
+ * On a track row of a version 3 container 't' sets the speed (as
+ * CHIPTUNE_EV_SPEED); older songs delay the instrument with it. */
+#define CHIPTUNE_COMMANDS      "0dfijlmtvw~+=pxkcq"
+
+/*
+ * Filter per channel, a resonant state-variable filter on the waveform
+ * before the volume: 'c' sets the cutoff, exponential from about 50 Hz
+ * (0x00) to 3.6 kHz (0xff), 'q' the resonance in its high nibble and the
+ * modes in its low one, or'd as on the SID (FILTER_LP | FILTER_HP is a
+ * notch). With no mode the filter is bypassed, as at song start.
+ */
+#define FILTER_LP              0x01
+#define FILTER_BP              0x02
+#define FILTER_HP              0x04
+#define FILTER_MODES           0x07
+
+/*
+ * Song container, version 3 (Chiptune_PlaySong, song bank entries): 'S'
+ * 'G', version, offset size (2 or 4), uint8 instruments, tracks and order
+ * positions, a reserved 0, then the resource table - order list,
+ * instruments 1..n, tracks 1..n - as offsets of that size, little endian,
+ * from the container start. The resources are bit-packed as in track.h.
+ * Version 2 has the same layout, but a track row's 't' is the instrument
+ * wait. Version 1 is track.h's songdata itself: a table of 13-bit
+ * offsets, so at most 8 KB, with the counts kept outside, and 't' as in
+ * version 2.
+ */
+#define SONG_VERSION           3
+#define SONG_VERSION_SPEED     3      /* first version whose track 't' sets the speed */
+#define SONG_HEADER            8
+
+/*
+ * Song bank (Chiptune_SetSongBank): 'S' 'B', version, song count, then a
+ * directory entry per song. Version 2: uint32 offset and uint32 length
+ * (bytes, little endian, from the bank start) of a song container.
+ * Version 1: uint16 offset and uint16 length of a version 1 song, uint8
+ * order positions and uint8 tracks.
+ */
+#define SONGBANK_VERSION       2
+#define SONGBANK_HEADER        4
+#define SONGBANK_ENTRY         8
+#define SONGBANK_ENTRY_V1      6
+
+/* Mixer selection: 1 = per-channel panned stereo, 0 = legacy mono mixer */
+#ifndef CHIPTUNE_STEREO
+#define CHIPTUNE_STEREO        1
+#endif
+
+/* Voice render rate as a multiple of the I2S rate: 1, 2 or 4. Above 1 the
+ * voices are decimated by the FIR in decimfir.h and band-limited mode is
+ * not available. */
+#ifndef CHIPTUNE_OVERSAMPLE
+#define CHIPTUNE_OVERSAMPLE    1
+#endif
+
+/* Play a song rendered at build time (Core/Inc/prerender.h, generated by
+ * 'make -C Tools prerender') instead of running the synth: the DMA
+ * half-transfer callbacks decode it and TIM2 is not used. */
+#ifndef CHIPTUNE_PRERENDERED
+#define CHIPTUNE_PRERENDERED   0
+#endif
+
+/* Start the song from the register dump in Core/Inc/regdump.h (generated
+ * by 'make -C Tools regdump') instead of the sequencer, see
+ * Chiptune_PlayDump(). */
+#ifndef CHIPTUNE_REPLAY
+#define CHIPTUNE_REPLAY        0
+#endif
+
+/* Register the songs in Core/Inc/songbank.h (generated by 'make -C Tools
+ * songbank') at startup; the user button steps through them. */
+#ifndef CHIPTUNE_SONGBANK
+#define CHIPTUNE_SONGBANK      0
+#endif
+
+/* Play MIDI in on USART3 RX (PD9) over the song, see midi.h */
+#ifndef CHIPTUNE_MIDI
+#define CHIPTUNE_MIDI          0
+#endif
+
+/* Take songs uploaded on USART2 (PA2/PA3) into flash and play them, see
+ * upload.h. Link with -Wl,--defsym=CHIPTUNE_UPLOAD=1 as well, which keeps
+ * the song slots out of the firmware (STM32F407VGTX_FLASH.ld). */
+#ifndef CHIPTUNE_UPLOAD
+#define CHIPTUNE_UPLOAD        0
+#endif
+
+/* Flash the firmware links into, less the song slots in upload builds */
+#define CHIPTUNE_FLASH_SIZE    ((CHIPTUNE_UPLOAD ? 768 : 1024) * 1024)
+
+/* Audio interrupt (TIM2) rate, the clock the sequencer ticks are counted in */
+#define CHIPTUNE_SAMPLE_RATE   8000
+
+/* Tempo at startup in BPM: ticks run at 2/5 of it per second, as in MOD
+ * files, so 125 is the 50 Hz tick. See CHIPTUNE_EV_TEMPO. */
+#ifndef CHIPTUNE_TEMPO
+#define CHIPTUNE_TEMPO         125
+#endif
+
+/* Instrument commands one channel may run per tick. A 'j' loop that never
+ * waits would otherwise hang the sequencer; past the budget the program
+ * resumes next tick and chiptune_stats_t.overruns counts it. Tools/instrcheck
+ * gives a song's worst case, so a tick is bounded by 4 channels of this. */
+#ifndef CHIPTUNE_INSTR_BUDGET
+#define CHIPTUNE_INSTR_BUDGET  32
+#endif
+
+/* Storage class of the engine state: empty on the target, thread-local in
+ * the host HAL stand-in so each thread of a tool runs its own engine. */
+#ifndef CHIPTUNE_TLS
+#define CHIPTUNE_TLS
+#endif
+
+/* Band-limited step residual table length */
+#define BLEP_LEN               32
+
+/* Pan positions (0x00 = hard left, 0x80 = centre, 0xFF = hard right) */
+#define PAN_LEFT               0x00
+#define PAN_CENTER             0x80
+#define PAN_RIGHT              0xFF
+
+/*
+ * Register dump format, one record per playroutine tick:
+ *   tick byte: bits 0-3 = channels that changed, bits 4-7 = unchanged
+ *              ticks that follow (0-15)
+ *   then per changed channel, a field mask followed by the fields it
+ *   sets, in bit order. Multi-byte fields are little endian.
+ */
+#define REGDUMP_FREQ           0x01   /* uint16 freq */
+#define REGDUMP_FREQ_DELTA     0x02   /* int8 added to freq */
+#define REGDUMP_DUTY           0x04   /* uint16 duty */
+#define REGDUMP_WAVEFORM       0x08   /* uint8 waveform */
+#define REGDUMP_VOLUME         0x10   /* uint8 volume */
+#define REGDUMP_PAN            0x20   /* uint8 pan */
+#define REGDUMP_TABLE          0x40   /* uint8 wavetable number */
+#define REGDUMP_SAMPLE         0x80   /* uint8 sample number (0xFF none), retriggers */
+#define REGDUMP_MAX_TICK       (1 + CHIPTUNE_CHANNELS * 11)
+/* The filter registers are not in the dump: Tools/regdump refuses songs
+ * that use them. */
+
+/*
+ * Engine state blob (Chiptune_SaveState): 'C' 'S', version, build config
+ * (bit 0 stereo, bits 1-3 oversampling factor), uint16 body length, then
+ * the body, little endian. Blobs only restore into the same version and
+ * build config.
+ */
+#define CHIPTUNE_STATE_VERSION 7
+#define CHIPTUNE_STATE_MAX     544
+
+/*
+ * Control events (Chiptune_PostEvent): a lock-free single-producer,
+ * single-consumer queue into the audio interrupt, which takes each event
+ * off at its sample. Only CHIPTUNE_EV_MUTE is sample-accurate: the mixer
+ * applies it at that sample. Every other event is tick-quantised, not
+ * sample-accurate: it is handed to the sequencer and plays from its next
+ * tick, like track rows, so it is heard up to a tick after its time, plus
+ * the wait for the main loop poll that runs the tick (see
+ * Chiptune_Process()). A channel event (notes, volume, bend, command,
+ * velocity) or'd with CHIPTUNE_EV_NOW is applied by the next
+ * Chiptune_Process() poll instead, for live input: a note runs the first
+ * tick of its instrument there and is heard from the next sample.
+ */
+#define CHIPTUNE_EVENTS        32     /* queue length, a power of two */
+#define CHIPTUNE_EV_NOW        0x80
 
 /* Buffer half definitions for DMA */
 #define FIRST_HALF             0
@@ -33,18 +206,103 @@ enum {
     WF_TRI = 0,
     WF_SAW,
     WF_PUL,
-    WF_NOI
+    WF_NOI,
+    WF_TABLE,
+    WF_SAMPLE
 };
 
+/* PCM sample formats */
+enum {
+    SAMPLE_PCM8 = 0,
+    SAMPLE_PCM16,
+    SAMPLE_ADPCM      /* IMA-ADPCM blocks, see adpcm.h */
+};
+
+/* Control event types */
+enum {
+    CHIPTUNE_EV_NOTE_ON = 0,  /* ch, value = note (as in tracks), arg = instrument 1-15 */
+    CHIPTUNE_EV_NOTE_OFF,     /* ch: stops the instrument and silences the voice */
+    CHIPTUNE_EV_MUTE,         /* value = mask of the muted channels, as Chiptune_SetMute() */
+    CHIPTUNE_EV_SONG,         /* value = song bank entry, see Chiptune_SelectSong() */
+    CHIPTUNE_EV_TEMPO,        /* value = BPM, 1-255; arg = ticks to ramp there, 0 = at once */
+    CHIPTUNE_EV_SPEED,        /* value = ticks per row, 4.4 fixed point (0x48 = 4.5), 0x10 up */
+    CHIPTUNE_EV_SFX,          /* value = effect (Chiptune_SetSfxBank), arg = note, ch = priority */
+    CHIPTUNE_EV_VOLUME,       /* ch, value = volume scale, see Chiptune_SetChannelVolume() */
+    CHIPTUNE_EV_BEND,         /* ch, value = pitch bend in 64ths of a semitone, signed */
+    CHIPTUNE_EV_COMMAND,      /* ch, value = command (CHIPTUNE_COMMANDS), arg = parameter */
+    CHIPTUNE_EV_VELOCITY,     /* ch, value = note velocity, 255 full, times the volume scale */
+    CHIPTUNE_EV_COUNT
+};
+
+/* Sample position fixed point: 20.12, up to 1M frames per sample */
+#define SAMPLE_FRAC_BITS       12
+
+/* Wavetables (CCMRAM), selected per channel with command 'x' */
+#define WAVETABLE_COUNT        8
+#define WAVETABLE_MAX_LEN      256
+
 /* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint8_t  shift;   /* phase >> shift indexes data: 11, 10 or 8 */
+    int8_t   data[WAVETABLE_MAX_LEN];  /* -32..31 like the fixed waveforms */
+} wavetable_t;
+
+/*
+ * PCM sample, normally a const object in flash. The mixer reads data in
+ * place; nothing is copied to RAM.
+ */
+typedef struct {
+    const void *data;     /* signed 8/16-bit mono frames, or ADPCM blocks */
+    uint32_t length;      /* frames */
+    uint32_t loopstart;   /* frames */
+    uint32_t looplen;     /* frames, 0 = one-shot */
+    uint16_t basefreq;    /* osc freq that plays the recorded rate (step 1.0) */
+    uint8_t  format;      /* SAMPLE_PCM8 or SAMPLE_PCM16 */
+} sample_t;
+
+/*
+ * Voice registers, set by the sequencer. The mixer plays a copy published
+ * whole once per tick, and keeps the phases and sample positions itself.
+ */
 typedef struct {
     uint16_t freq;
-    uint16_t phase;
     uint16_t duty;
     uint8_t  waveform;
     uint8_t  volume;  // 0-255
+    uint8_t  pan;     // PAN_LEFT..PAN_RIGHT
+    uint8_t  trigger; // bumped to play sample from its first frame
+    uint32_t gain;    // mixed volume after the live mix controls: packed stereo,
+                      // left in bits 0-15 and right in 16-31, or mono as is
+    const wavetable_t *table;  // WF_TABLE source
+    const sample_t *sample;    // WF_SAMPLE source
+    uint32_t sstep;   // sample step per output sample, 20.12 frames
+    uint8_t  cutoff;  // command 'c'
+    uint8_t  filter;  // command 'q': resonance << 4 | FILTER_ modes
+    uint32_t svf[3];  // filter coefficients from both, packed 16-bit pairs
 } oscillator_t;
 
+typedef struct {
+    uint32_t time;    /* Chiptune_GetTime() sample it applies at, earlier = now */
+    uint8_t  type;    /* CHIPTUNE_EV_* */
+    uint8_t  ch;
+    uint8_t  value;
+    uint8_t  arg;
+} chiptune_event_t;
+
+/*
+ * Sound effect: an instrument program (2-byte lines as in songs: command
+ * number, parameter) played over the music on a borrowed channel. It
+ * starts at 'note' with the voice silent, and ends at a '0' command or
+ * past its last line, handing the channel back to the music, which kept
+ * playing underneath. A program that never ends holds the channel until
+ * an effect of the same or higher priority takes it.
+ */
+typedef struct {
+    const uint8_t *program;
+    uint8_t length;           /* lines */
+    uint8_t channels;         /* mask of the channels it may borrow */
+} chiptune_sfx_t;
+
 struct trackline {
     uint8_t note;
     uint8_t instr;
@@ -57,7 +315,7 @@ struct track {
 };
 
 struct unpacker {
-    uint16_t nextbyte;
+    uint32_t nextbyte;
     uint8_t  buffer;
     uint8_t  bits;
 };
@@ -83,18 +341,67 @@ struct channel {
     uint16_t slur;
 };
 
+/*
+ * Register dump of a song, normally a const object in flash generated by
+ * Tools/regdump. Format described with REGDUMP_FREQ.
+ */
+typedef struct {
+    const uint8_t *data;
+    uint32_t length;      /* bytes */
+    uint32_t songticks;   /* ticks until the song ends, the rest is release */
+} regdump_t;
+
+typedef struct {
+    profile_counter_t mix;   /* Chiptune_AudioCallback, per sample */
+    profile_counter_t tick;  /* playroutine, per tick */
+    profile_counter_t adpcm; /* ADPCM_DecodeBlock, per ADPCM_BLOCK_FRAMES */
+    profile_counter_t song;  /* song switch, per Chiptune_SelectSong */
+    uint32_t overruns;       /* instruments cut short by CHIPTUNE_INSTR_BUDGET */
+    uint32_t sfxlatency;     /* worst effect start after its event time, samples */
+    uint32_t sfxdropped;     /* effects with no channel free at their priority */
+    uint32_t livelatency;    /* worst CHIPTUNE_EV_NOW event applied after its event time, samples */
+} chiptune_stats_t;
+
 /* Exported variables --------------------------------------------------------*/
-extern volatile uint8_t timetoplay;
-extern volatile uint8_t callbackwait;
-extern volatile uint16_t lastsample16;
-extern volatile oscillator_t osc[4];
+extern CHIPTUNE_TLS volatile uint8_t timetoplay;
+extern CHIPTUNE_TLS volatile uint8_t callbackwait;
+extern CHIPTUNE_TLS volatile uint16_t lastsample16;
+extern CHIPTUNE_TLS oscillator_t osc[4];
 
 /* Exported functions --------------------------------------------------------*/
 void Chiptune_Init(void);
 void Chiptune_Process(void);
+void Chiptune_Tick(void);
 void Chiptune_AudioCallback(void);
 void Chiptune_FillBuffer(uint8_t half);
 uint16_t* getAudioBuffer(void);
+uint16_t Chiptune_GetWriteFrame(void);
+uint8_t Chiptune_IsPlaying(void);
+void Chiptune_UpdateVoices(void);
+void Chiptune_SetPan(uint8_t ch, uint8_t pan);
+void Chiptune_SetMute(uint8_t mask);
+void Chiptune_SetSolo(uint8_t mask);
+void Chiptune_SetChannelVolume(uint8_t ch, uint8_t scale);
+void Chiptune_SetTranspose(int8_t semitones);
+void Chiptune_SetSfxBank(const chiptune_sfx_t *bank, uint8_t count);
+uint8_t Chiptune_GetSfxChannels(void);
+void Chiptune_SetBandLimited(uint8_t enable);
+HAL_StatusTypeDef Chiptune_LoadWavetable(uint8_t num, const int8_t *samples, uint16_t len);
+HAL_StatusTypeDef Chiptune_SetSampleBank(const sample_t *bank, uint8_t count);
+void Chiptune_PlayDump(const regdump_t *dump);
+HAL_StatusTypeDef Chiptune_BuildSeekIndex(void);
+HAL_StatusTypeDef Chiptune_Seek(uint8_t order, uint8_t row);
+HAL_StatusTypeDef Chiptune_SetLoop(uint8_t order);
+HAL_StatusTypeDef Chiptune_SetSongBank(const uint8_t *bank, uint32_t len);
+HAL_StatusTypeDef Chiptune_SelectSong(uint8_t num);
+HAL_StatusTypeDef Chiptune_PlaySong(const uint8_t *song, uint32_t len);
+uint8_t Chiptune_GetSong(void);
+HAL_StatusTypeDef Chiptune_PostEvent(const chiptune_event_t *event);
+uint32_t Chiptune_GetTime(void);
+HAL_StatusTypeDef Chiptune_SaveState(uint8_t *blob, uint32_t size, uint32_t *len);
+HAL_StatusTypeDef Chiptune_LoadState(const uint8_t *blob, uint32_t len);
+void Chiptune_GetStats(chiptune_stats_t *stats);
+void Chiptune_ResetStats(void);
 
 /* Legacy compatibility functions */
 void chiptune_callback(void);
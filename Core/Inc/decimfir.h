@@ -0,0 +1,35 @@
+/**
+  ******************************************************************************
+  * @file           : decimfir.h
+  * @brief          : Oversampling decimation FIR taps (Q15)
+  ******************************************************************************
+  *
+  * Generated by Tools/decimgen 12 - do not edit, run 'make -C Tools fir'.
+  *
+  */
+
+#ifndef __DECIMFIR_H
+#define __DECIMFIR_H
+
+#include <stdint.h>
+
+#define DECIM2_TAPS            24
+
+static const int16_t decim2_taps[DECIM2_TAPS] __attribute__((aligned(4))) = {
+        0,      5,     25,    -47,   -185,     92,    709,     96,
+    -1975,  -1316,   5534,  13446,  13446,   5534,  -1316,  -1975,
+       96,    709,     92,   -185,    -47,     25,      5,      0
+};
+
+#define DECIM4_TAPS            48
+
+static const int16_t decim4_taps[DECIM4_TAPS] __attribute__((aligned(4))) = {
+        0,      0,      2,      7,     14,     13,     -8,    -50,
+      -92,    -96,    -21,    135,    312,    386,    231,   -193,
+     -758,  -1163,  -1028,    -78,   1686,   3909,   5969,   7207,
+     7207,   5969,   3909,   1686,    -78,  -1028,  -1163,   -758,
+     -193,    231,    386,    312,    135,    -21,    -96,    -92,
+      -50,     -8,     13,     14,      7,      2,      0,      0
+};
+
+#endif /* __DECIMFIR_H */
@@ -46,6 +46,11 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
+/* Core-coupled RAM: zero-wait for the CPU, not reachable by DMA, and not
+ * initialised by the startup code - contents must be set at run time */
+#ifndef CCMRAM
+#define CCMRAM __attribute__((section(".ccmram")))
+#endif
 
 /* USER CODE END EM */
 
@@ -53,6 +58,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void UPLOAD_UART_Receive(uint8_t byte);
 
 /* USER CODE END EFP */
 
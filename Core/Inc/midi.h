@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : midi.h
+  * @brief          : MIDI input: UART receive ring and running-status parser
+  ******************************************************************************
+  *
+  * The UART receives into a MIDI_RX_SIZE byte ring by circular DMA. Its
+  * idle-line interrupt and the DMA half and full transfer interrupts pass
+  * the DMA write position to Midi_RxInterrupt(), which stamps the bytes up
+  * to it with Chiptune_GetTime(). Midi_Process(), polled by the main loop
+  * next to Chiptune_Process(), parses them and posts each message as
+  * CHIPTUNE_EV_NOW events at that time, so a note sounds within a few
+  * main loop polls of its last byte (Tools/midibench measures it).
+  *
+  * MIDI channels 1-4 play engine channels 0-3, one note at a time each:
+  *   note on       CHIPTUNE_EV_NOTE_ON of the channel's program, note
+  *                 MIDI_NOTE_OFFSET playing freqtable's first entry (C1),
+  *                 after a CHIPTUNE_EV_VELOCITY of its velocity
+  *   note off      CHIPTUNE_EV_NOTE_OFF if it is the note playing
+  *   program       instrument 1-15 for the next notes (programs 0-14)
+  *   pitch bend    CHIPTUNE_EV_BEND, +-2 semitones
+  *   CC 1          vibrato depth, command '~' (rate from CC 76)
+  *   CC 7          channel volume, CHIPTUNE_EV_VOLUME
+  *   CC 10         pan, command 'p'
+  *   CC 74         pulse duty, command 'd'
+  *   CC 120, 123   note off
+  *   CC 121        bend, vibrato and channel volume back to their defaults
+  * The instrument program may set the same registers on later ticks.
+  * Real-time bytes are ignored wherever they fall; system exclusive and
+  * common messages are skipped and end running status.
+  *
+  */
+
+#ifndef __MIDI_H
+#define __MIDI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_BAUD              31250
+#define MIDI_RX_SIZE           32     /* receive ring, bytes: a half every 5 ms at full rate */
+#define MIDI_NOTE_OFFSET       24     /* MIDI note of engine note 0 */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint32_t messages;    /* channel messages parsed */
+    uint32_t dropped;     /* events lost to a full Chiptune_PostEvent() queue */
+    uint32_t overruns;    /* times the receive ring filled before a poll, its bytes lost */
+} midi_stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+void Midi_Init(void);
+uint8_t *Midi_GetRxBuffer(void);
+void Midi_RxInterrupt(uint16_t pos);
+void Midi_Process(void);
+void Midi_GetStats(midi_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_H */
@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file           : profile.h
+  * @brief          : DWT cycle counter helpers for engine profiling
+  ******************************************************************************
+  *
+  * Build with CHIPTUNE_PROFILE defined to enable the counters. Without it
+  * every helper compiles to nothing and the counters read as zero.
+  *
+  */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint32_t last;   /* cycles of the most recent run */
+    uint32_t max;    /* worst case since the last reset */
+    uint32_t total;  /* sum over count runs, wraps */
+    uint32_t count;  /* number of runs */
+} profile_counter_t;
+
+/* Exported functions --------------------------------------------------------*/
+#ifdef CHIPTUNE_PROFILE
+
+static inline void Profile_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t Profile_Now(void)
+{
+    return DWT->CYCCNT;
+}
+
+static inline void Profile_Update(volatile profile_counter_t *pc, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+
+    pc->last = cycles;
+    if(cycles > pc->max) pc->max = cycles;
+    pc->total += cycles;
+    pc->count++;
+}
+
+#else
+
+static inline void Profile_Init(void) {}
+static inline uint32_t Profile_Now(void) { return 0; }
+static inline void Profile_Update(volatile profile_counter_t *pc, uint32_t start)
+{
+    (void)pc;
+    (void)start;
+}
+
+#endif /* CHIPTUNE_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROFILE_H */
@@ -1,22 +1,32 @@
+/**
+  ******************************************************************************
+  * @file           : track.h
+  * @brief          : Built-in song
+  ******************************************************************************
+  *
+  * Generated by Tools/songc - do not edit, run 'make -C Tools song'.
+  *
+  */
+
 #ifndef TRACK_H_INCLUDED
 #define TRACK_H_INCLUDED
 
 #include <stdint.h>
 
-#define MAXTRACK        0x92
-#define SONGLEN		    0x37
+#define MAXTRACK        0x39
+#define SONGLEN         0x37
 
 const uint8_t songdata[] = {
-    0x77, 0x00, 0x2a, 0x84, 0x05, 0xbb, 0x90, 0x18, 0x40, 0xc3, 0x6c, 0x50,
-    0x0e, 0xd1, 0x41, 0x3e, 0x4c, 0x08, 0x1a, 0xb1, 0x24, 0xa4, 0x44, 0x99,
-    0x30, 0x13, 0x67, 0x82, 0x50, 0x60, 0x0a, 0x53, 0x11, 0x2c, 0x9e, 0x45,
-    0xbe, 0xe8, 0x18, 0x2b, 0xe3, 0x68, 0x9c, 0x8d, 0xc2, 0xd1, 0x39, 0x60,
-    0xc7, 0xf5, 0xe0, 0x1f, 0x1c, 0x64, 0x88, 0x84, 0x11, 0x3c, 0xb2, 0x48,
-    0x4e, 0x49, 0x2d, 0x89, 0x26, 0xe8, 0x84, 0x9f, 0x38, 0x94, 0x8e, 0x92,
-    0x53, 0x9e, 0x4a, 0x57, 0xb1, 0x2b, 0x8d, 0x45, 0xb5, 0x14, 0x97, 0xe9,
-    0x32, 0x5e, 0xe8, 0x0b, 0x83, 0x29, 0x31, 0x40, 0xc6, 0xcc, 0x28, 0x9a,
-    0x51, 0x63, 0x6c, 0xaa, 0xcd, 0xb8, 0xe1, 0x37, 0x10, 0x27, 0xe5, 0x54,
-    0x1d, 0xb9, 0x73, 0x7a, 0x72, 0x4f, 0xf2, 0xc9, 0x3e, 0x03, 0x08, 0x00,
+    0x77, 0x00, 0x2a, 0x84, 0x85, 0xba, 0x80, 0x18, 0x3e, 0x83, 0x6c, 0x48,
+    0x0e, 0xd0, 0x01, 0x3e, 0x40, 0x08, 0x18, 0x71, 0x24, 0x9c, 0x44, 0x98,
+    0x10, 0x13, 0x63, 0x02, 0x50, 0x50, 0x0a, 0x51, 0xd1, 0x2b, 0x96, 0x45,
+    0xbd, 0xc8, 0x18, 0x27, 0x63, 0x68, 0x8c, 0x8d, 0xc0, 0x91, 0x39, 0x58,
+    0xc7, 0xf4, 0xc0, 0x1f, 0x18, 0xe4, 0x87, 0x74, 0x11, 0x3a, 0x72, 0x48,
+    0x66, 0xcb, 0x28, 0xf9, 0x25, 0xd6, 0x44, 0x9d, 0xf0, 0x93, 0x85, 0x72,
+    0x52, 0x7a, 0xca, 0x52, 0x21, 0x2b, 0x7b, 0x05, 0xb3, 0xcc, 0x96, 0xe0,
+    0x12, 0x5d, 0xc4, 0x8b, 0x7e, 0x99, 0x30, 0x2e, 0x86, 0xca, 0xe0, 0x99,
+    0x48, 0x43, 0x6b, 0x86, 0x4d, 0xb4, 0x51, 0x37, 0xfe, 0xe6, 0xe2, 0x0c,
+    0x1d, 0xb0, 0x53, 0x79, 0x4e, 0xcf, 0xed, 0x39, 0x3e, 0xf1, 0x07, 0x00,
     0x00, 0x1b, 0x00, 0x00, 0xa8, 0xb5, 0x00, 0x80, 0x9b, 0x2b, 0x00, 0x00,
     0x00, 0x02, 0x00, 0x00, 0x20, 0x90, 0x18, 0x00, 0x02, 0x09, 0x00, 0x20,
     0x90, 0x00, 0x4c, 0x02, 0x09, 0x00, 0x25, 0x90, 0x00, 0x54, 0x0e, 0x09,
@@ -34,155 +44,153 @@ const uint8_t songdata[] = {
     0x8c, 0x66, 0x35, 0x8e, 0xc9, 0x8c, 0xe6, 0x34, 0x8c, 0xf8, 0xcc, 0xe7,
     0x34, 0x8c, 0xf8, 0xcc, 0x27, 0x35, 0x8c, 0xf8, 0xcc, 0x67, 0x35, 0x8c,
     0xf8, 0xcc, 0xe7, 0x34, 0x8c, 0xf8, 0xcc, 0xe7, 0x34, 0x8c, 0xf8, 0xcc,
-    0x27, 0x35, 0x88, 0xed, 0xcc, 0xe7, 0x35, 0x90, 0xee, 0x28, 0x5a, 0x03,
+    0x27, 0x35, 0x88, 0xed, 0xcc, 0xe7, 0x35, 0x90, 0xee, 0x28, 0x8e, 0x09,
     0x09, 0x03, 0x08, 0xff, 0x07, 0x01, 0x09, 0x02, 0x01, 0x90, 0x0b, 0x31,
     0x05, 0xa0, 0x02, 0xf0, 0x00, 0x08, 0xff, 0x09, 0x03, 0x07, 0x02, 0x09,
     0x02, 0x0b, 0x31, 0x01, 0x70, 0x05, 0xd0, 0x07, 0x02, 0x02, 0xf8, 0x04,
-    0x01, 0x00, 0x09, 0x02, 0x06, 0x05, 0x0b, 0x31, 0x08, 0xff, 0x02, 0xf0,
-    0x07, 0x06, 0x02, 0x00, 0x07, 0x16, 0x0a, 0x25, 0x00, 0x09, 0x03, 0x08,
-    0xff, 0x07, 0x01, 0x09, 0x00, 0x06, 0x05, 0x0b, 0x3d, 0x02, 0xf0, 0x07,
-    0x06, 0x02, 0x00, 0x07, 0x20, 0x02, 0xf0, 0x00, 0x09, 0x03, 0x08, 0xff,
-    0x07, 0x01, 0x09, 0x02, 0x01, 0x50, 0x06, 0x01, 0x0b, 0x31, 0x07, 0x05,
-    0x02, 0xfe, 0x00, 0x09, 0x02, 0x01, 0x80, 0x0b, 0x3d, 0x08, 0xc0, 0x02,
-    0x08, 0x07, 0x02, 0x02, 0xf0, 0x07, 0x02, 0x02, 0x00, 0x07, 0x16, 0x0a,
-    0x34, 0x00, 0x09, 0x03, 0x08, 0xff, 0x02, 0xfc, 0x00, 0x03, 0x00, 0x09,
-    0x03, 0x08, 0xff, 0x07, 0x01, 0x09, 0x02, 0x06, 0x05, 0x02, 0xff, 0x0b,
-    0x3d, 0x07, 0x03, 0x0b, 0x38, 0x07, 0x03, 0x0b, 0x34, 0x07, 0x03, 0x0b,
-    0x31, 0x07, 0x03, 0x04, 0x07, 0x00, 0x03, 0x00, 0x09, 0x03, 0x08, 0xff,
-    0x07, 0x01, 0x09, 0x02, 0x06, 0x05, 0x02, 0xff, 0x0b, 0x3d, 0x07, 0x03,
-    0x0b, 0x38, 0x07, 0x03, 0x0b, 0x35, 0x07, 0x03, 0x0b, 0x31, 0x07, 0x03,
-    0x04, 0x07, 0x00, 0x03, 0x00, 0x09, 0x03, 0x08, 0xff, 0x07, 0x01, 0x09,
-    0x02, 0x06, 0x05, 0x02, 0xff, 0x0b, 0x3d, 0x07, 0x03, 0x0b, 0x38, 0x07,
-    0x03, 0x0b, 0x36, 0x07, 0x03, 0x0b, 0x31, 0x07, 0x03, 0x04, 0x07, 0x00,
-    0x09, 0x03, 0x08, 0xff, 0x07, 0x01, 0x09, 0x00, 0x06, 0x05, 0x0b, 0x3d,
-    0x02, 0xf0, 0x07, 0x06, 0x02, 0x00, 0x07, 0x06, 0x0a, 0x25, 0x00, 0x09,
-    0x03, 0x08, 0xff, 0x02, 0xf0, 0x00, 0x08, 0xc4, 0x09, 0x00, 0x06, 0x05,
-    0x0b, 0x3d, 0x02, 0xf0, 0x07, 0x06, 0x02, 0x00, 0x07, 0x06, 0x0a, 0x25,
-    0x00, 0x00, 0x00, 0x6b, 0x04, 0x00, 0x20, 0x0d, 0x2c, 0x23, 0x58, 0x23,
-    0x00, 0xb4, 0x81, 0x80, 0x44, 0xc0, 0x34, 0x90, 0x06, 0xd2, 0xc0, 0x32,
-    0x02, 0x60, 0x8d, 0x40, 0x1a, 0x00, 0x11, 0x00, 0x6b, 0x04, 0xd2, 0x00,
-    0x00, 0x2c, 0x23, 0x00, 0x80, 0x35, 0x02, 0x00, 0x90, 0x06, 0x80, 0x65,
-    0x04, 0x00, 0x00, 0x00, 0x94, 0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x8b, 0x45, 0x62,
-    0x89, 0x25, 0x96, 0x18, 0x12, 0x03, 0x90, 0x18, 0xc2, 0x42, 0x58, 0x00,
-    0xc2, 0x42, 0x4a, 0x48, 0x09, 0x01, 0x21, 0x20, 0x00, 0x2b, 0x1d, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xcb,
-    0x08, 0x11, 0x6a, 0x8d, 0x48, 0x23, 0x0d, 0xa4, 0x81, 0x65, 0x84, 0x08,
-    0xd0, 0x0c, 0x42, 0x11, 0x01, 0xd6, 0x08, 0xa4, 0x81, 0x65, 0x84, 0x08,
-    0xb5, 0x46, 0x20, 0x0d, 0xa4, 0x81, 0x65, 0x84, 0x08, 0xb5, 0x46, 0x20,
-    0x8d, 0x34, 0xd2, 0x48, 0x03, 0x6b, 0x04, 0x00, 0x20, 0x0d, 0x2c, 0x23,
-    0x44, 0x80, 0x35, 0x02, 0x40, 0x1b, 0x08, 0x98, 0xc6, 0x32, 0x42, 0x04,
-    0x58, 0x23, 0x90, 0x06, 0xd2, 0xc0, 0x32, 0x82, 0x35, 0x02, 0xcb, 0x08,
-    0x11, 0x20, 0x19, 0x22, 0x00, 0x6b, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa7, 0xd1, 0x00, 0x20, 0x25,
-    0x84, 0x86, 0xcc, 0x90, 0x12, 0x12, 0x43, 0x6c, 0xc8, 0x0c, 0xa1, 0x21,
-    0x25, 0x84, 0x86, 0xcc, 0x90, 0x12, 0x12, 0x43, 0x66, 0xc8, 0x0b, 0xc7,
-    0xcd, 0x00, 0x00, 0x44, 0x60, 0x00, 0x48, 0x0c, 0x20, 0x02, 0x03, 0x40,
-    0x70, 0x44, 0x20, 0x22, 0x00, 0x82, 0x23, 0x02, 0x24, 0x07, 0x10, 0x01,
-    0x62, 0x23, 0x02, 0xa4, 0x87, 0xdc, 0x00, 0xc3, 0x0d, 0x40, 0x04, 0x06,
-    0x80, 0xc4, 0x00, 0x22, 0x30, 0x00, 0x04, 0x87, 0xd8, 0x10, 0x1a, 0x11,
-    0x20, 0x31, 0x80, 0x08, 0x10, 0x1a, 0x11, 0x20, 0xb8, 0xe4, 0xb2, 0x4b,
-    0x0f, 0x03, 0x0e, 0x80, 0x00, 0x91, 0x1e, 0x80, 0xe4, 0x10, 0x21, 0x02,
-    0x44, 0x7e, 0x08, 0x10, 0x11, 0x22, 0x3b, 0x00, 0xc1, 0x21, 0x33, 0xc4,
-    0x06, 0x03, 0x0e, 0xf2, 0x03, 0x11, 0x00, 0xe9, 0x01, 0x00, 0x00, 0x00,
-    0x00, 0x28, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8b, 0x0d, 0x11, 0x20,
-    0x33, 0x22, 0x30, 0x10, 0x1a, 0x88, 0x00, 0x48, 0x8c, 0x08, 0x1c, 0x1b,
-    0x11, 0x20, 0x31, 0x22, 0x40, 0x70, 0xb1, 0x85, 0x86, 0xe0, 0x88, 0x00,
-    0xb1, 0x21, 0x34, 0x22, 0x40, 0x66, 0x44, 0x80, 0xc4, 0x00, 0x00, 0x63,
-    0x0d, 0xe7, 0x3f, 0x25, 0x24, 0x86, 0x94, 0x10, 0x16, 0x52, 0x42, 0x62,
-    0x1c, 0x80, 0x94, 0x10, 0x5a, 0x66, 0x89, 0x85, 0x15, 0x55, 0x50, 0x29,
-    0x05, 0x14, 0x4e, 0x3c, 0xf9, 0x04, 0x94, 0x52, 0x5a, 0x89, 0x05, 0x07,
-    0x2b, 0x0d, 0xe7, 0x3f, 0x19, 0x24, 0x83, 0xa0, 0x90, 0x0c, 0x52, 0x42,
-    0x58, 0xc8, 0x08, 0x29, 0x21, 0x19, 0x24, 0x83, 0xa0, 0x90, 0x17, 0xc2,
-    0xe2, 0x00, 0xa4, 0x94, 0x53, 0x50, 0x61, 0x01, 0x63, 0x0d, 0xe7, 0x3f,
-    0x31, 0x24, 0x83, 0xb0, 0x90, 0x12, 0x92, 0x41, 0x58, 0x44, 0x80, 0xc6,
-    0x06, 0x80, 0x08, 0x90, 0x0c, 0xe7, 0x3f, 0x2c, 0xa4, 0x84, 0x64, 0x90,
-    0x12, 0x92, 0xe1, 0x00, 0x84, 0x45, 0x04, 0xc8, 0x8b, 0x08, 0x00, 0xa3,
-    0x0d, 0x11, 0x20, 0x36, 0x00, 0xc1, 0x11, 0x01, 0x81, 0xd0, 0x90, 0x5d,
-    0x72, 0xc1, 0x21, 0x3b, 0xa4, 0x87, 0xfc, 0x88, 0x00, 0x11, 0x02, 0x08,
-    0x0e, 0x99, 0x21, 0x36, 0x00, 0x6b, 0x14, 0x12, 0x00, 0x00, 0x80, 0x08,
-    0x00, 0xc4, 0x10, 0x44, 0x16, 0x48, 0x03, 0x09, 0x20, 0x01, 0x00, 0x20,
-    0x02, 0x00, 0x00, 0x00, 0x00, 0xb0, 0x46, 0x01, 0x44, 0x40, 0x20, 0x0d,
-    0x10, 0x01, 0x90, 0x06, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4b,
-    0x14, 0x00, 0x20, 0x15, 0x10, 0x01, 0x10, 0x08, 0x92, 0x40, 0x0c, 0xc8,
-    0x02, 0x59, 0x00, 0x44, 0x80, 0x20, 0x88, 0xc0, 0x40, 0x06, 0x44, 0x60,
-    0x20, 0x08, 0x00, 0x0b, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x4b, 0x14, 0x00, 0x20, 0x15, 0x10, 0x01,
-    0x10, 0x08, 0x92, 0x40, 0x0c, 0x08, 0x02, 0x41, 0x00, 0x44, 0x80, 0x20,
-    0x88, 0xc0, 0x40, 0x06, 0x44, 0x60, 0x20, 0x08, 0x00, 0x43, 0x19, 0x00,
-    0x00, 0x00, 0x80, 0x8c, 0x40, 0x04, 0x40, 0x56, 0x00, 0x40, 0x04, 0x88,
-    0x0a, 0x00, 0x88, 0x00, 0x41, 0x01, 0x44, 0x00, 0x3b, 0x19, 0x00, 0x10,
-    0x01, 0x82, 0x22, 0x02, 0x44, 0x05, 0x00, 0x00, 0x00, 0x4a, 0x3f, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x23, 0x19, 0x00, 0x00, 0x00, 0x80, 0x98, 0x00,
-    0x04, 0x05, 0x00, 0x00, 0x42, 0x02, 0x58, 0xf8, 0x00, 0x00, 0x1b, 0x19,
-    0x00, 0x00, 0xa0, 0xfc, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x3b, 0x19, 0x80, 0x9c, 0x10, 0x14, 0x80, 0xa0, 0x10, 0x15, 0x00,
-    0x0a, 0x3e, 0x80, 0xb4, 0x00, 0xa4, 0x85, 0xa8, 0x88, 0x00, 0x21, 0x11,
-    0x01, 0x32, 0x22, 0x02, 0x00, 0x43, 0x19, 0x00, 0x0a, 0x3f, 0x80, 0xac,
-    0x00, 0x50, 0xf8, 0x01, 0x44, 0x05, 0x80, 0xc2, 0x0f, 0x20, 0x26, 0xb0,
-    0x06, 0x00, 0x00, 0x43, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x23, 0x14, 0x80, 0x10, 0x10, 0x08, 0x80,
-    0x2c, 0x10, 0x07, 0xf2, 0x40, 0x08, 0x00, 0x42, 0x40, 0x20, 0x00, 0xb2,
-    0x40, 0x20, 0x81, 0x64, 0x11, 0x02, 0x5b, 0x14, 0x80, 0x2c, 0x90, 0x0b,
-    0x80, 0x18, 0x90, 0x04, 0xa2, 0x40, 0x16, 0x00, 0xd2, 0x00, 0x10, 0x07,
-    0x80, 0x3c, 0x58, 0xe0, 0x00, 0x63, 0x14, 0xc2, 0x00, 0x11, 0x00, 0x39,
-    0x20, 0x0a, 0x84, 0x01, 0x22, 0x00, 0xa2, 0x40, 0x18, 0x08, 0x03, 0x44,
-    0x00, 0xe4, 0x80, 0x3c, 0x10, 0x07, 0xc2, 0x40, 0x0a, 0x00, 0x3b, 0x14,
-    0x72, 0x00, 0x90, 0x09, 0x80, 0x40, 0x10, 0x07, 0xb2, 0x40, 0x12, 0x39,
-    0xe4, 0x92, 0x4a, 0x26, 0x81, 0xc4, 0x91, 0x44, 0x0e, 0x00, 0x92, 0x00,
-    0x00, 0x5b, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x63, 0x14, 0x00, 0x00, 0x00, 0x80, 0x30, 0x00, 0xc4,
-    0x01, 0x00, 0x00, 0x00, 0x20, 0x0e, 0x00, 0x83, 0x14, 0x00, 0x20, 0x10,
-    0x10, 0x01, 0x00, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x2b, 0x1d, 0x00, 0x00, 0x00, 0x86, 0x42, 0x00, 0x41, 0x11, 0x01, 0x82,
-    0x02, 0x00, 0x84, 0x46, 0x04, 0x04, 0x42, 0x23, 0x02, 0x04, 0x05, 0x00,
-    0x1b, 0x25, 0x00, 0x10, 0x01, 0xf2, 0x22, 0x02, 0x02, 0x19, 0x01, 0xc8,
-    0x88, 0x08, 0x90, 0x17, 0x80, 0x8c, 0x00, 0x64, 0x84, 0xbc, 0x90, 0x11,
-    0x00, 0x23, 0x25, 0x00, 0x10, 0x01, 0x02, 0x23, 0x02, 0x02, 0x21, 0x01,
-    0x08, 0x89, 0x08, 0x10, 0x12, 0x00, 0x20, 0x30, 0x22, 0x20, 0x10, 0x18,
-    0x11, 0x20, 0x24, 0x00, 0x5b, 0x25, 0x11, 0x20, 0x1f, 0x80, 0x08, 0x90,
-    0x15, 0x11, 0x20, 0x2b, 0x22, 0x40, 0x3e, 0x00, 0x11, 0x20, 0x2b, 0x22,
-    0x40, 0x56, 0x44, 0x80, 0x7c, 0x00, 0x22, 0x40, 0x3e, 0x00, 0xb2, 0x22,
-    0x02, 0x02, 0xf9, 0x10, 0x01, 0x00, 0x23, 0x25, 0x80, 0x90, 0x88, 0x00,
-    0x81, 0x81, 0x08, 0x80, 0xc0, 0x88, 0x00, 0x21, 0x01, 0x88, 0x09, 0x44,
-    0x00, 0xc4, 0x44, 0x04, 0x88, 0x0c, 0x20, 0x02, 0x44, 0x46, 0x04, 0x88,
-    0x89, 0x08, 0x10, 0x19, 0x11, 0x00, 0xa3, 0x25, 0x42, 0x0b, 0x2d, 0x34,
-    0x22, 0x40, 0x50, 0x20, 0x02, 0x20, 0x28, 0x22, 0x40, 0x50, 0x08, 0x0d,
-    0x41, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa3, 0x29, 0x42, 0x0b, 0x2a,
-    0x34, 0x22, 0x40, 0x50, 0x20, 0x02, 0x20, 0x28, 0x22, 0x40, 0x50, 0x00,
-    0x42, 0x43, 0x68, 0xa1, 0x85, 0x46, 0x04, 0x08, 0x0a, 0x44, 0x00, 0x04,
-    0x45, 0x04, 0x08, 0x0a, 0xa1, 0x01, 0x0b, 0x25, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0xc8, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x21, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b,
-    0x1d, 0x00, 0x00, 0x18, 0x6b, 0x91, 0x12, 0x80, 0xb0, 0x90, 0x18, 0xc2,
-    0x42, 0x4a, 0x08, 0x8d, 0x02, 0x90, 0x19, 0xc2, 0x42, 0x4a, 0x88, 0x0d,
-    0xc3, 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x0c,
-    0xa1, 0xc5, 0x96, 0x5b, 0x70, 0xd9, 0xa5, 0x07, 0x03, 0x2e, 0x00, 0x00,
-    0x48, 0x0f, 0x40, 0x80, 0x00, 0xf2, 0x23, 0x02, 0x64, 0x07, 0x22, 0x00,
-    0x82, 0x03, 0x10, 0x1c, 0x11, 0x20, 0x3f, 0x64, 0x07, 0x03, 0x6e, 0x7e,
-    0xe9, 0x05, 0x17, 0x5a, 0x66, 0xb1, 0x65, 0x16, 0x5a, 0x66, 0x89, 0x85,
-    0x95, 0x57, 0x54, 0x99, 0xe5, 0x95, 0x18, 0x11, 0x20, 0x31, 0x22, 0x40,
-    0x62, 0x44, 0x80, 0xc4, 0x00, 0x22, 0x40, 0x62, 0x44, 0x80, 0xf4, 0x88,
-    0x00, 0x89, 0x11, 0x01, 0x00, 0x03, 0x2e, 0x12, 0x43, 0x62, 0x48, 0x0f,
-    0x89, 0x21, 0x3d, 0x44, 0x18, 0x60, 0x7e, 0x08, 0x10, 0x89, 0x21, 0x31,
-    0xa4, 0x87, 0xc4, 0x90, 0x1e, 0x22, 0x0c, 0x30, 0x3f, 0x00, 0xfb, 0x2d,
-    0x02, 0x24, 0x02, 0x84, 0x48, 0x04, 0x48, 0x6f, 0xc4, 0x9e, 0x70, 0xd7,
-    0xeb, 0xc5, 0x76, 0xc2, 0x1e, 0x70, 0x17, 0xeb, 0xe1, 0x76, 0xc0, 0xde,
-    0x6f, 0xd7, 0xeb, 0xc5, 0x76, 0xbf, 0xde, 0x6e, 0x17, 0xeb, 0xe1, 0x76,
-    0xbb, 0x1e, 0x6e, 0x87, 0xeb, 0xc5, 0x76, 0xc4, 0xde, 0x6e, 0x17, 0xeb,
-    0xf5, 0x36, 0x3f, 0xa3, 0x0d, 0x00, 0x00, 0x48, 0x0c, 0x40, 0x68, 0x00,
-    0x32, 0x03, 0x00, 0x00, 0x89, 0x01, 0xc8, 0x0b, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xbd, 0x26, 0xb1, 0xcc,
-    0x00, 0x7f, 0x4d, 0x41, 0x00, 0x48, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x21, 0x11, 0x20, 0x25, 0x80, 0x08,
-    0x90, 0x58, 0x62, 0x29, 0x11, 0x01, 0x52, 0x22, 0x02, 0x00, 0x29, 0x11,
-    0x01, 0x56, 0x52, 0x22, 0x00, 0x90, 0x12, 0x11, 0x60, 0x25, 0x24, 0x02,
-    0x00, 0x29, 0x11, 0x01, 0x52, 0x22, 0x02, 0xa4, 0x44, 0x04, 0x00, 0xcf,
-    0xcc, 0xc0, 0x11, 0x01, 0x52, 0x22, 0x02, 0xa4, 0x44, 0x04, 0x48, 0x86,
-    0x08, 0x90, 0x12, 0x11, 0x20, 0x19, 0x22, 0x40, 0x4a, 0x44, 0x80, 0x94,
-    0x88, 0x00, 0xc9, 0x10, 0x01, 0x52, 0x22, 0x02, 0xa4, 0x44, 0x04, 0x48,
-    0x86, 0x08, 0x90, 0x12, 0x11, 0xa0, 0x99, 0x01, 0x68, 0x46, 0x80, 0x53,
-    0x22, 0x02, 0xa4, 0x44, 0x04
+    0x01, 0x09, 0x02, 0x06, 0x05, 0x0b, 0x31, 0x08, 0xff, 0x02, 0xf0, 0x07,
+    0x06, 0x02, 0x00, 0x07, 0x16, 0x0a, 0x25, 0x00, 0x09, 0x03, 0x08, 0xff,
+    0x07, 0x01, 0x09, 0x00, 0x06, 0x05, 0x0b, 0x3d, 0x02, 0xf0, 0x07, 0x06,
+    0x02, 0x00, 0x07, 0x20, 0x02, 0xf0, 0x00, 0x09, 0x03, 0x08, 0xff, 0x07,
+    0x01, 0x09, 0x02, 0x01, 0x50, 0x06, 0x01, 0x0b, 0x31, 0x07, 0x05, 0x02,
+    0xfe, 0x00, 0x09, 0x02, 0x01, 0x80, 0x0b, 0x3d, 0x08, 0xc0, 0x02, 0x08,
+    0x07, 0x02, 0x02, 0xf0, 0x07, 0x02, 0x02, 0x00, 0x07, 0x16, 0x0a, 0x34,
+    0x00, 0x09, 0x03, 0x08, 0xff, 0x02, 0xfc, 0x00, 0x03, 0x00, 0x09, 0x03,
+    0x08, 0xff, 0x07, 0x01, 0x09, 0x02, 0x06, 0x05, 0x02, 0xff, 0x0b, 0x3d,
+    0x07, 0x03, 0x0b, 0x38, 0x07, 0x03, 0x0b, 0x34, 0x07, 0x03, 0x0b, 0x31,
+    0x07, 0x03, 0x04, 0x07, 0x03, 0x00, 0x09, 0x03, 0x08, 0xff, 0x07, 0x01,
+    0x09, 0x02, 0x06, 0x05, 0x02, 0xff, 0x0b, 0x3d, 0x07, 0x03, 0x0b, 0x38,
+    0x07, 0x03, 0x0b, 0x35, 0x07, 0x03, 0x0b, 0x31, 0x07, 0x03, 0x04, 0x07,
+    0x03, 0x00, 0x09, 0x03, 0x08, 0xff, 0x07, 0x01, 0x09, 0x02, 0x06, 0x05,
+    0x02, 0xff, 0x0b, 0x3d, 0x07, 0x03, 0x0b, 0x38, 0x07, 0x03, 0x0b, 0x36,
+    0x07, 0x03, 0x0b, 0x31, 0x07, 0x03, 0x04, 0x07, 0x09, 0x03, 0x08, 0xff,
+    0x07, 0x01, 0x09, 0x00, 0x06, 0x05, 0x0b, 0x3d, 0x02, 0xf0, 0x07, 0x06,
+    0x02, 0x00, 0x07, 0x06, 0x0a, 0x25, 0x00, 0x09, 0x03, 0x08, 0xff, 0x02,
+    0xf0, 0x00, 0x08, 0xc4, 0x09, 0x00, 0x06, 0x05, 0x0b, 0x3d, 0x02, 0xf0,
+    0x07, 0x06, 0x02, 0x00, 0x07, 0x06, 0x0a, 0x25, 0x00, 0x00, 0x00, 0x6b,
+    0x04, 0x00, 0x20, 0x0d, 0x2c, 0x23, 0x58, 0x23, 0x00, 0xb4, 0x81, 0x80,
+    0x44, 0xc0, 0x34, 0x90, 0x06, 0xd2, 0xc0, 0x32, 0x02, 0x60, 0x8d, 0x40,
+    0x1a, 0x00, 0x11, 0x00, 0x6b, 0x04, 0xd2, 0x00, 0x00, 0x2c, 0x23, 0x00,
+    0x80, 0x35, 0x02, 0x00, 0x90, 0x06, 0x80, 0x65, 0x04, 0x00, 0x00, 0x00,
+    0x94, 0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x38, 0x00, 0x8b, 0x45, 0x62, 0x89, 0x25, 0x96, 0x18,
+    0x12, 0x03, 0x90, 0x18, 0xc2, 0x42, 0x58, 0x00, 0xc2, 0x42, 0x4a, 0x48,
+    0x09, 0x01, 0x21, 0x20, 0x00, 0x2b, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xcb, 0x08, 0x11, 0x6a, 0x8d,
+    0x48, 0x23, 0x0d, 0xa4, 0x81, 0x65, 0x84, 0x08, 0xd0, 0x0c, 0x42, 0x11,
+    0x01, 0xd6, 0x08, 0xa4, 0x81, 0x65, 0x84, 0x08, 0xb5, 0x46, 0x20, 0x0d,
+    0xa4, 0x81, 0x65, 0x84, 0x08, 0xb5, 0x46, 0x20, 0x8d, 0x34, 0xd2, 0x48,
+    0x03, 0x6b, 0x04, 0x00, 0x20, 0x0d, 0x2c, 0x23, 0x44, 0x80, 0x35, 0x02,
+    0x40, 0x1b, 0x08, 0x98, 0xc6, 0x32, 0x42, 0x04, 0x58, 0x23, 0x90, 0x06,
+    0xd2, 0xc0, 0x32, 0x82, 0x35, 0x02, 0xcb, 0x08, 0x11, 0x20, 0x19, 0x22,
+    0x00, 0x6b, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xa7, 0xd1, 0x00, 0x20, 0x25, 0x84, 0x86, 0xcc, 0x90,
+    0x12, 0x12, 0x43, 0x6c, 0xc8, 0x0c, 0xa1, 0x21, 0x25, 0x84, 0x86, 0xcc,
+    0x90, 0x12, 0x12, 0x43, 0x66, 0xc8, 0x0b, 0xc7, 0xcd, 0x00, 0x00, 0x44,
+    0x60, 0x00, 0x48, 0x0c, 0x20, 0x02, 0x03, 0x40, 0x70, 0x44, 0x20, 0x22,
+    0x00, 0x82, 0x23, 0x02, 0x24, 0x07, 0x10, 0x01, 0x62, 0x23, 0x02, 0xa4,
+    0x87, 0xdc, 0x00, 0xc3, 0x0d, 0x40, 0x04, 0x06, 0x80, 0xc4, 0x00, 0x22,
+    0x30, 0x00, 0x04, 0x87, 0xd8, 0x10, 0x1a, 0x11, 0x20, 0x31, 0x80, 0x08,
+    0x10, 0x1a, 0x11, 0x20, 0xb8, 0xe4, 0xb2, 0x4b, 0x0f, 0x03, 0x0e, 0x80,
+    0x00, 0x91, 0x1e, 0x80, 0xe4, 0x10, 0x21, 0x02, 0x44, 0x7e, 0x08, 0x10,
+    0x11, 0x22, 0x3b, 0x00, 0xc1, 0x21, 0x33, 0xc4, 0x06, 0x03, 0x0e, 0xf2,
+    0x03, 0x11, 0x00, 0xe9, 0x01, 0x00, 0x00, 0x00, 0x00, 0x28, 0xfe, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x8b, 0x0d, 0x11, 0x20, 0x33, 0x22, 0x30, 0x10,
+    0x1a, 0x88, 0x00, 0x48, 0x8c, 0x08, 0x1c, 0x1b, 0x11, 0x20, 0x31, 0x22,
+    0x40, 0x70, 0xb1, 0x85, 0x86, 0xe0, 0x88, 0x00, 0xb1, 0x21, 0x34, 0x22,
+    0x40, 0x66, 0x44, 0x80, 0xc4, 0x00, 0x00, 0x63, 0x0d, 0xe7, 0x3f, 0x25,
+    0x24, 0x86, 0x94, 0x10, 0x16, 0x52, 0x42, 0x62, 0x1c, 0x80, 0x94, 0x10,
+    0x5a, 0x66, 0x89, 0x85, 0x15, 0x55, 0x50, 0x29, 0x05, 0x14, 0x4e, 0x3c,
+    0xf9, 0x04, 0x94, 0x52, 0x5a, 0x89, 0x05, 0x07, 0x2b, 0x0d, 0xe7, 0x3f,
+    0x19, 0x24, 0x83, 0xa0, 0x90, 0x0c, 0x52, 0x42, 0x58, 0xc8, 0x08, 0x29,
+    0x21, 0x19, 0x24, 0x83, 0xa0, 0x90, 0x17, 0xc2, 0xe2, 0x00, 0xa4, 0x94,
+    0x53, 0x50, 0x61, 0x01, 0x63, 0x0d, 0xe7, 0x3f, 0x31, 0x24, 0x83, 0xb0,
+    0x90, 0x12, 0x92, 0x41, 0x58, 0x44, 0x80, 0xc6, 0x06, 0x80, 0x08, 0x90,
+    0x0c, 0xe7, 0x3f, 0x2c, 0xa4, 0x84, 0x64, 0x90, 0x12, 0x92, 0xe1, 0x00,
+    0x84, 0x45, 0x04, 0xc8, 0x8b, 0x08, 0x00, 0xa3, 0x0d, 0x11, 0x20, 0x36,
+    0x00, 0xc1, 0x11, 0x01, 0x81, 0xd0, 0x90, 0x5d, 0x72, 0xc1, 0x21, 0x3b,
+    0xa4, 0x87, 0xfc, 0x88, 0x00, 0x11, 0x02, 0x08, 0x0e, 0x99, 0x21, 0x36,
+    0x00, 0x6b, 0x14, 0x12, 0x00, 0x00, 0x80, 0x08, 0x00, 0xc4, 0x10, 0x44,
+    0x16, 0x48, 0x03, 0x09, 0x20, 0x01, 0x00, 0x20, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0xb0, 0x46, 0x01, 0x44, 0x40, 0x20, 0x0d, 0x10, 0x01, 0x90, 0x06,
+    0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4b, 0x14, 0x00, 0x20, 0x15,
+    0x10, 0x01, 0x10, 0x08, 0x92, 0x40, 0x0c, 0xc8, 0x02, 0x59, 0x00, 0x44,
+    0x80, 0x20, 0x88, 0xc0, 0x40, 0x06, 0x44, 0x60, 0x20, 0x08, 0x00, 0x4b,
+    0x14, 0x00, 0x20, 0x15, 0x10, 0x01, 0x10, 0x08, 0x92, 0x40, 0x0c, 0x08,
+    0x02, 0x41, 0x00, 0x44, 0x80, 0x20, 0x88, 0xc0, 0x40, 0x06, 0x44, 0x60,
+    0x20, 0x08, 0x00, 0x43, 0x19, 0x00, 0x00, 0x00, 0x80, 0x8c, 0x40, 0x04,
+    0x40, 0x56, 0x00, 0x40, 0x04, 0x88, 0x0a, 0x00, 0x88, 0x00, 0x41, 0x01,
+    0x44, 0x00, 0x3b, 0x19, 0x00, 0x10, 0x01, 0x82, 0x22, 0x02, 0x44, 0x05,
+    0x00, 0x00, 0x00, 0x4a, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x23, 0x19,
+    0x00, 0x00, 0x00, 0x80, 0x98, 0x00, 0x04, 0x05, 0x00, 0x00, 0x42, 0x02,
+    0x58, 0xf8, 0x00, 0x00, 0x1b, 0x19, 0x00, 0x00, 0xa0, 0xfc, 0x03, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3b, 0x19, 0x80, 0x9c, 0x10,
+    0x14, 0x80, 0xa0, 0x10, 0x15, 0x00, 0x0a, 0x3e, 0x80, 0xb4, 0x00, 0xa4,
+    0x85, 0xa8, 0x88, 0x00, 0x21, 0x11, 0x01, 0x32, 0x22, 0x02, 0x00, 0x43,
+    0x19, 0x00, 0x0a, 0x3f, 0x80, 0xac, 0x00, 0x50, 0xf8, 0x01, 0x44, 0x05,
+    0x80, 0xc2, 0x0f, 0x20, 0x26, 0xb0, 0x06, 0x00, 0x00, 0x43, 0x19, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x23,
+    0x14, 0x80, 0x10, 0x10, 0x08, 0x80, 0x2c, 0x10, 0x07, 0xf2, 0x40, 0x08,
+    0x00, 0x42, 0x40, 0x20, 0x00, 0xb2, 0x40, 0x20, 0x81, 0x64, 0x11, 0x02,
+    0x5b, 0x14, 0x80, 0x2c, 0x90, 0x0b, 0x80, 0x18, 0x90, 0x04, 0xa2, 0x40,
+    0x16, 0x00, 0xd2, 0x00, 0x10, 0x07, 0x80, 0x3c, 0x58, 0xe0, 0x00, 0x63,
+    0x14, 0xc2, 0x00, 0x11, 0x00, 0x39, 0x20, 0x0a, 0x84, 0x01, 0x22, 0x00,
+    0xa2, 0x40, 0x18, 0x08, 0x03, 0x44, 0x00, 0xe4, 0x80, 0x3c, 0x10, 0x07,
+    0xc2, 0x40, 0x0a, 0x00, 0x3b, 0x14, 0x72, 0x00, 0x90, 0x09, 0x80, 0x40,
+    0x10, 0x07, 0xb2, 0x40, 0x12, 0x39, 0xe4, 0x92, 0x4a, 0x26, 0x81, 0xc4,
+    0x91, 0x44, 0x0e, 0x00, 0x92, 0x00, 0x00, 0x5b, 0x14, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63, 0x14, 0x00,
+    0x00, 0x00, 0x80, 0x30, 0x00, 0xc4, 0x01, 0x00, 0x00, 0x00, 0x20, 0x0e,
+    0x00, 0x83, 0x14, 0x00, 0x20, 0x10, 0x10, 0x01, 0x00, 0x84, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x1d, 0x00, 0x00, 0x00, 0x86,
+    0x42, 0x00, 0x41, 0x11, 0x01, 0x82, 0x02, 0x00, 0x84, 0x46, 0x04, 0x04,
+    0x42, 0x23, 0x02, 0x04, 0x05, 0x00, 0x1b, 0x25, 0x00, 0x10, 0x01, 0xf2,
+    0x22, 0x02, 0x02, 0x19, 0x01, 0xc8, 0x88, 0x08, 0x90, 0x17, 0x80, 0x8c,
+    0x00, 0x64, 0x84, 0xbc, 0x90, 0x11, 0x00, 0x23, 0x25, 0x00, 0x10, 0x01,
+    0x02, 0x23, 0x02, 0x02, 0x21, 0x01, 0x08, 0x89, 0x08, 0x10, 0x12, 0x00,
+    0x20, 0x30, 0x22, 0x20, 0x10, 0x18, 0x11, 0x20, 0x24, 0x00, 0x5b, 0x25,
+    0x11, 0x20, 0x1f, 0x80, 0x08, 0x90, 0x15, 0x11, 0x20, 0x2b, 0x22, 0x40,
+    0x3e, 0x00, 0x11, 0x20, 0x2b, 0x22, 0x40, 0x56, 0x44, 0x80, 0x7c, 0x00,
+    0x22, 0x40, 0x3e, 0x00, 0xb2, 0x22, 0x02, 0x02, 0xf9, 0x10, 0x01, 0x00,
+    0x23, 0x25, 0x80, 0x90, 0x88, 0x00, 0x81, 0x81, 0x08, 0x80, 0xc0, 0x88,
+    0x00, 0x21, 0x01, 0x88, 0x09, 0x44, 0x00, 0xc4, 0x44, 0x04, 0x88, 0x0c,
+    0x20, 0x02, 0x44, 0x46, 0x04, 0x88, 0x89, 0x08, 0x10, 0x19, 0x11, 0x00,
+    0xa3, 0x25, 0x42, 0x0b, 0x2d, 0x34, 0x22, 0x40, 0x50, 0x20, 0x02, 0x20,
+    0x28, 0x22, 0x40, 0x50, 0x08, 0x0d, 0x41, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xa3, 0x29, 0x42, 0x0b, 0x2a, 0x34, 0x22, 0x40, 0x50, 0x20, 0x02,
+    0x20, 0x28, 0x22, 0x40, 0x50, 0x00, 0x42, 0x43, 0x68, 0xa1, 0x85, 0x46,
+    0x04, 0x08, 0x0a, 0x44, 0x00, 0x04, 0x45, 0x04, 0x08, 0x0a, 0xa1, 0x01,
+    0x0b, 0x25, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc8, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x2b, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x1d, 0x00, 0x00, 0x18, 0x6b, 0x91,
+    0x12, 0x80, 0xb0, 0x90, 0x18, 0xc2, 0x42, 0x4a, 0x08, 0x8d, 0x02, 0x90,
+    0x19, 0xc2, 0x42, 0x4a, 0x88, 0x0d, 0xc3, 0x2d, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x48, 0x0c, 0xa1, 0xc5, 0x96, 0x5b, 0x70, 0xd9,
+    0xa5, 0x07, 0x03, 0x2e, 0x00, 0x00, 0x48, 0x0f, 0x40, 0x80, 0x00, 0xf2,
+    0x23, 0x02, 0x64, 0x07, 0x22, 0x00, 0x82, 0x03, 0x10, 0x1c, 0x11, 0x20,
+    0x3f, 0x64, 0x07, 0x03, 0x6e, 0x7e, 0xe9, 0x05, 0x17, 0x5a, 0x66, 0xb1,
+    0x65, 0x16, 0x5a, 0x66, 0x89, 0x85, 0x95, 0x57, 0x54, 0x99, 0xe5, 0x95,
+    0x18, 0x11, 0x20, 0x31, 0x22, 0x40, 0x62, 0x44, 0x80, 0xc4, 0x00, 0x22,
+    0x40, 0x62, 0x44, 0x80, 0xf4, 0x88, 0x00, 0x89, 0x11, 0x01, 0x00, 0x03,
+    0x2e, 0x12, 0x43, 0x62, 0x48, 0x0f, 0x89, 0x21, 0x3d, 0x44, 0x18, 0x60,
+    0x7e, 0x08, 0x10, 0x89, 0x21, 0x31, 0xa4, 0x87, 0xc4, 0x90, 0x1e, 0x22,
+    0x0c, 0x30, 0x3f, 0x00, 0xfb, 0x2d, 0x02, 0x24, 0x02, 0x84, 0x48, 0x04,
+    0x48, 0x6f, 0xc4, 0x9e, 0x70, 0xd7, 0xeb, 0xc5, 0x76, 0xc2, 0x1e, 0x70,
+    0x17, 0xeb, 0xe1, 0x76, 0xc0, 0xde, 0x6f, 0xd7, 0xeb, 0xc5, 0x76, 0xbf,
+    0xde, 0x6e, 0x17, 0xeb, 0xe1, 0x76, 0xbb, 0x1e, 0x6e, 0x87, 0xeb, 0xc5,
+    0x76, 0xc4, 0xde, 0x6e, 0x17, 0xeb, 0xf5, 0x36, 0x3f, 0xa3, 0x0d, 0x00,
+    0x00, 0x48, 0x0c, 0x40, 0x68, 0x00, 0x32, 0x03, 0x00, 0x00, 0x89, 0x01,
+    0xc8, 0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x80, 0xbd, 0x26, 0xb1, 0xcc, 0x00, 0x7f, 0x4d, 0x41, 0x00, 0x48,
+    0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b,
+    0x21, 0x11, 0x20, 0x25, 0x80, 0x08, 0x90, 0x58, 0x62, 0x29, 0x11, 0x01,
+    0x52, 0x22, 0x02, 0x00, 0x29, 0x11, 0x01, 0x56, 0x52, 0x22, 0x00, 0x90,
+    0x12, 0x11, 0x60, 0x25, 0x24, 0x02, 0x00, 0x29, 0x11, 0x01, 0x52, 0x22,
+    0x02, 0xa4, 0x44, 0x04, 0x00, 0xcf, 0xcc, 0xc0, 0x11, 0x01, 0x52, 0x22,
+    0x02, 0xa4, 0x44, 0x04, 0x48, 0x86, 0x08, 0x90, 0x12, 0x11, 0x20, 0x19,
+    0x22, 0x40, 0x4a, 0x44, 0x80, 0x94, 0x88, 0x00, 0xc9, 0x10, 0x01, 0x52,
+    0x22, 0x02, 0xa4, 0x44, 0x04, 0x48, 0x86, 0x08, 0x90, 0x12, 0x11, 0xa0,
+    0x99, 0x01, 0x68, 0x46, 0x80, 0x53, 0x22, 0x02, 0xa4, 0x44, 0x04, 0x00,
 };
 
 #endif /* TRACK_H_INCLUDED */
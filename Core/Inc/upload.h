@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * @file           : upload.h
+  * @brief          : Song upload: framed transfers into spare flash slots
+  ******************************************************************************
+  *
+  * A new song, a song container (format in chiptune.h), is pushed to
+  * a running unit over any byte stream, an upload_transport_t: USART2 in
+  * main.c on the board, a pipe for Tools/songup on the host. It is written
+  * into a spare flash slot while the current song plays, then switched to
+  * with Chiptune_PlaySong() at a tick, and played from that slot again at
+  * startup.
+  *
+  * Frame, multi-byte fields little-endian:
+  *   UPLOAD_SYNC, type, seq, payload length (2 bytes), payload,
+  *   CRC-16/CCITT of type through payload (2 bytes)
+  * The sender waits for each reply before the next frame: UPLOAD_ACK or
+  * UPLOAD_NAK with the frame's seq, the NAK carrying an UPLOAD_ERR_ byte.
+  * On no reply, or a NAK for UPLOAD_ERR_CRC or UPLOAD_ERR_BUSY, it sends
+  * the frame again; one repeated after a lost ACK is acknowledged again
+  * and not taken twice.
+  *   UPLOAD_BEGIN  song length (4 bytes), its CRC-32 (4 bytes): takes an
+  *                 erased slot, abandoning an upload in progress
+  *   UPLOAD_DATA   offset (4 bytes, a multiple of 4, in order), then up to
+  *                 UPLOAD_CHUNK bytes
+  *   UPLOAD_END    no payload: acknowledged once the slot is programmed,
+  *                 holds the CRC-32 given and the engine takes the song
+  *
+  * Flash: sectors 10 and 11, kept out of the firmware by the linker
+  * script when linked with --defsym=CHIPTUNE_UPLOAD=1, hold one song each
+  * behind a small header whose first word is programmed last, so a slot
+  * counts only once it is complete. The newest one plays at startup.
+  * Programming a word stalls flash reads for less than a sample period, so
+  * the audio interrupt is only delayed, and Upload_Process() programs a
+  * few words per poll from a double buffer while the next chunk arrives.
+  * Erasing a sector stalls them for a second or more, so only Upload_Init()
+  * erases, the spare slots before the audio starts. A refused frame does
+  * not end the upload; a new UPLOAD_BEGIN does, or UPLOAD_TIMEOUT_MS
+  * without a frame. A slot such an upload left part programmed is taken
+  * again by a UPLOAD_BEGIN of the same song, which resumes over the words
+  * already there. A slot holding anything else from this run is reclaimed
+  * at the next startup, and with both so used an upload is refused with
+  * UPLOAD_ERR_NOSLOT until then.
+  *
+  */
+
+#ifndef __UPLOAD_H
+#define __UPLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define UPLOAD_BAUD            115200
+#define UPLOAD_SYNC            0xA5
+#define UPLOAD_CHUNK           256    /* data bytes per UPLOAD_DATA frame, at most */
+#define UPLOAD_FRAME_MAX       (7 + 4 + UPLOAD_CHUNK)
+
+/* Frame types */
+#define UPLOAD_BEGIN           0x01
+#define UPLOAD_DATA            0x02
+#define UPLOAD_END             0x03
+#define UPLOAD_ACK             0x81
+#define UPLOAD_NAK             0x82
+
+/* UPLOAD_NAK errors */
+#define UPLOAD_ERR_CRC         1      /* frame damaged, send it again */
+#define UPLOAD_ERR_BUSY        2      /* still programming, send it again */
+#define UPLOAD_ERR_SEQUENCE    3      /* frame out of order or malformed */
+#define UPLOAD_ERR_SIZE        4      /* song larger than a slot */
+#define UPLOAD_ERR_NOSLOT      5      /* no erased slot until the next startup */
+#define UPLOAD_ERR_FLASH       6      /* programming failed */
+#define UPLOAD_ERR_SONG        7      /* CRC-32 differs, or not a song the engine plays */
+
+/* Song slots: flash sectors 10 and 11 */
+#define UPLOAD_SLOTS           2
+#define UPLOAD_SLOT_ADDR       0x080C0000U
+#define UPLOAD_SLOT_SIZE       0x20000U
+#define UPLOAD_SLOT_SECTOR     FLASH_SECTOR_10
+#define UPLOAD_SLOT_HEADER     16
+#define UPLOAD_SONG_MAX        (UPLOAD_SLOT_SIZE - UPLOAD_SLOT_HEADER)
+
+/* Flash words programmed per Upload_Process(), at most */
+#define UPLOAD_WORDS           16
+
+/* An upload with no frame for this long is abandoned */
+#define UPLOAD_TIMEOUT_MS      2000
+
+/* Reads flash at a HAL address; the host stand-in maps it to memory */
+#ifndef UPLOAD_FLASH
+#define UPLOAD_FLASH(addr)     ((const uint8_t *)(addr))
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+/* A byte stream; neither call may wait for the other end */
+typedef struct {
+    /* Bytes received since the last call, up to 'max' */
+    uint16_t (*read)(uint8_t *buf, uint16_t max);
+    /* Sends a reply frame */
+    void (*write)(const uint8_t *buf, uint16_t len);
+} upload_transport_t;
+
+typedef struct {
+    uint32_t frames;      /* frames received whole */
+    uint32_t damaged;     /* frames failing their CRC-16 */
+    uint32_t busy;        /* frames refused while programming */
+    uint32_t uploads;     /* songs switched to */
+    uint32_t refused;     /* frames refused with another error */
+    uint32_t resumed;     /* uploads taken up in the slot of an abandoned one */
+} upload_stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+void Upload_Init(const upload_transport_t *transport);
+void Upload_Process(void);
+void Upload_GetStats(upload_stats_t *stats);
+uint16_t Upload_Frame(uint8_t *out, uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len);
+uint16_t Upload_Crc16(const uint8_t *data, uint32_t len, uint16_t crc);
+uint32_t Upload_Crc32(const uint8_t *data, uint32_t len, uint32_t crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UPLOAD_H */
@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file           : adpcm.c
+  * @brief          : IMA-ADPCM block codec for compressed samples
+  ******************************************************************************
+  */
+
+#include "adpcm.h"
+
+/* Private variables ---------------------------------------------------------*/
+static const int16_t steptable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37,
+    41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173,
+    190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+    20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t indextable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+static inline int16_t decodenibble(uint8_t code, int32_t *pred, int8_t *index)
+{
+    int32_t step = steptable[*index];
+    int32_t diff = step >> 3;
+
+    if(code & 4) diff += step;
+    if(code & 2) diff += step >> 1;
+    if(code & 1) diff += step >> 2;
+    if(code & 8) *pred -= diff;
+    else *pred += diff;
+
+    if(*pred > 32767) *pred = 32767;
+    if(*pred < -32768) *pred = -32768;
+
+    *index += indextable[code];
+    if(*index < 0) *index = 0;
+    if(*index > 88) *index = 88;
+
+    return (int16_t)*pred;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/*
+ * Decode one block into ADPCM_BLOCK_FRAMES samples.
+ */
+void ADPCM_DecodeBlock(const uint8_t *block, int16_t *out)
+{
+    int32_t pred = (int16_t)(block[0] | (block[1] << 8));
+    int8_t index = block[2] > 88 ? 88 : block[2];
+    const uint8_t *codes = block + 4;
+    uint16_t i;
+
+    for(i = 0; i < ADPCM_BLOCK_FRAMES / 2; i++)
+    {
+        uint8_t b = codes[i];
+
+        *out++ = decodenibble(b & 15, &pred, &index);
+        *out++ = decodenibble(b >> 4, &pred, &index);
+    }
+}
+
+/*
+ * Encode up to ADPCM_BLOCK_FRAMES samples into one block; a short final
+ * block is padded by repeating the last sample. The quantiser tracks the
+ * decoder state, so decoding reproduces exactly what was encoded against.
+ */
+void ADPCM_EncodeBlock(const int16_t *in, uint32_t frames, uint8_t *block)
+{
+    int32_t pred = frames ? in[0] : 0;
+    int8_t index = 0;
+    uint32_t i;
+
+    /* Start with a step that fits the first transient */
+    if(frames > 1)
+    {
+        int32_t delta = in[1] - in[0];
+
+        if(delta < 0) delta = -delta;
+        while(index < 88 && steptable[index] < delta) index++;
+    }
+
+    block[0] = (uint8_t)pred;
+    block[1] = (uint8_t)(pred >> 8);
+    block[2] = (uint8_t)index;
+    block[3] = 0;
+
+    for(i = 0; i < ADPCM_BLOCK_FRAMES; i++)
+    {
+        int32_t target = frames ? in[i < frames ? i : frames - 1] : 0;
+        int32_t diff = target - pred;
+        int32_t step = steptable[index];
+        uint8_t code = 0;
+        int32_t tmp = pred;
+        int8_t tmpindex = index;
+
+        if(diff < 0)
+        {
+            code = 8;
+            diff = -diff;
+        }
+        if(diff >= step) { code |= 4; diff -= step; }
+        step >>= 1;
+        if(diff >= step) { code |= 2; diff -= step; }
+        step >>= 1;
+        if(diff >= step) code |= 1;
+
+        /* Advance with the decoder's arithmetic, not the encoder's */
+        decodenibble(code, &tmp, &tmpindex);
+        pred = tmp;
+        index = tmpindex;
+
+        if(i & 1) block[4 + i / 2] |= (uint8_t)(code << 4);
+        else block[4 + i / 2] = code;
+    }
+}
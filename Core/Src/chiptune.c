@@ -8,34 +8,280 @@
 #include "chiptune.h"
 #include "track.h"
 #include "main.h"
+#include "adpcm.h"
+#include <string.h>
+
+#if SONGLEN > SONG_MAX_ORDERS || MAXTRACK > SONG_MAX_TRACKS
+#error "Built-in song exceeds SONG_MAX_ORDERS or SONG_MAX_TRACKS"
+#endif
+
+#if CHIPTUNE_PRERENDERED
+#include "prerender.h"
+#if AUDIO_BUFFER_SIZE / 4 != ADPCM_BLOCK_FRAMES
+#error "Prerendered playback decodes one ADPCM block per DMA half-buffer"
+#endif
+#endif
+
+#if CHIPTUNE_OVERSAMPLE == 2 || CHIPTUNE_OVERSAMPLE == 4
+#include "decimfir.h"
+#elif CHIPTUNE_OVERSAMPLE != 1
+#error "CHIPTUNE_OVERSAMPLE must be 1, 2 or 4"
+#endif
+
+#if CHIPTUNE_OVERSAMPLE == 2
+#define DECIM_TAPS             DECIM2_TAPS
+#define decim_taps             decim2_taps
+#elif CHIPTUNE_OVERSAMPLE == 4
+#define DECIM_TAPS             DECIM4_TAPS
+#define decim_taps             decim4_taps
+#endif
+
+/* Private types -------------------------------------------------------------*/
+#if CHIPTUNE_STEREO
+typedef uint32_t mix_t;     /* left in bits 0-15, right in 16-31 */
+#else
+typedef int16_t mix_t;
+#endif
+
+/* Sequencer state at the start of an order position, see Chiptune_Seek() */
+typedef struct {
+    struct unpacker songup;
+    struct channel channel[CHIPTUNE_CHANNELS];
+    struct {
+        uint16_t freq;
+        uint16_t duty;
+        uint8_t  waveform;
+        uint8_t  volume;
+        uint8_t  pan;
+        const wavetable_t *table;
+        const sample_t *sample;
+        uint8_t  cutoff;
+        uint8_t  filter;
+    } osc[CHIPTUNE_CHANNELS];
+    uint8_t trackwait;
+    uint8_t rowspeed;
+} seekpoint_t;
+
+/* A song and its counts: the built-in songdata, a bank entry or a container */
+typedef struct {
+    const uint8_t *base;
+    uint32_t bytes;
+    uint8_t version;      /* 1: 13-bit resource table, counts from outside;
+                           * SONG_VERSION_SPEED up: track 't' is the speed */
+    uint8_t instruments;
+    uint8_t tracks;
+    uint8_t orders;
+} songinfo_t;
+
+/* Mixer state of a voice, owned by the audio interrupt */
+typedef struct {
+    uint16_t phase;
+    uint16_t blepfreq;        /* freq that bleprcp was computed for */
+    uint32_t bleprcp;         /* (BLEP_LEN << 16) / blepfreq */
+    const sample_t *sample;   /* playing, NULL when a one-shot finished */
+    uint32_t spos;            /* sample position, 20.12 frames */
+    uint8_t trigger;          /* oscillator_t trigger last started */
+    uint32_t svf;             /* filter integrators: ic1 in bits 0-15, ic2 in 16-31 */
+    uint32_t svferr;          /* bits v1 and v2 dropped last sample, likewise */
+} voice_t;
+
+/* Single-producer, single-consumer event ring: each index has one writer */
+typedef struct {
+    chiptune_event_t ev[CHIPTUNE_EVENTS];
+    volatile uint8_t head;    /* next free slot, written by the producer */
+    volatile uint8_t tail;    /* oldest event, written by the consumer */
+} evqueue_t;
+
+/* ADPCM decode ring per voice: the block being played and the next one */
+typedef struct {
+    const sample_t *src[2];
+    uint32_t block[2];
+    int16_t frames[2][ADPCM_BLOCK_FRAMES];
+} adpcmring_t;
 
 /* Private variables ---------------------------------------------------------*/
-volatile uint16_t lastsample16 = 0;
-volatile uint32_t audioTicks = 0;  /* Counter at 8kHz rate */
+CHIPTUNE_TLS volatile uint16_t lastsample16 = 0;
+CHIPTUNE_TLS volatile uint32_t audioTicks = 0;  /* Counter at 8kHz rate */
+
+CHIPTUNE_TLS uint8_t trackwait = 0;
+CHIPTUNE_TLS uint8_t trackpos = 0;
+CHIPTUNE_TLS uint8_t playsong = 0;
+CHIPTUNE_TLS uint8_t songpos = 0;
+
+CHIPTUNE_TLS uint32_t noiseseed = 1;
+static CHIPTUNE_TLS uint32_t noisebits;    /* next 32 LFSR output bits, MSB first */
+static CHIPTUNE_TLS uint8_t noisecount;    /* bits left in noisebits */
+
+/* Band-limited saw/pulse enable */
+static CHIPTUNE_TLS uint8_t bandlimit = 0;
+CHIPTUNE_TLS uint8_t light[2] = {0};
+
+/* Audio DMA double buffer, addressable per sample or per L/R frame */
+static CHIPTUNE_TLS union {
+    uint16_t sample[AUDIO_BUFFER_SIZE];
+    uint32_t frame[AUDIO_BUFFER_SIZE / 2];
+} audioBuffer;
+static CHIPTUNE_TLS volatile uint32_t bufferIndex = 0;
+
+/*
+ * Tick schedule on the sample clock: the next tick is due at sample
+ * nexttick, with tickfrac carrying the fraction of the period (samples,
+ * 16.16) so that no tempo drifts. A ramp adds tickstep to the period for
+ * rampticks ticks, then lands on rampperiod.
+ */
+static CHIPTUNE_TLS uint32_t nexttick;
+static CHIPTUNE_TLS uint16_t tickfrac;
+static CHIPTUNE_TLS uint32_t tickperiod;
+static CHIPTUNE_TLS int32_t tickstep;
+static CHIPTUNE_TLS uint32_t rampperiod;
+static CHIPTUNE_TLS uint8_t rampticks;
 
-uint8_t trackwait = 0;
-uint8_t trackpos = 0;
-uint8_t playsong = 0;
-uint8_t songpos = 0;
+/* Ticks per row, 4.4 fixed point; trackwait counts sixteenths of a tick */
+static CHIPTUNE_TLS uint8_t rowspeed = TICKS_PER_ROW << 4;
 
-uint32_t noiseseed = 1;
-uint8_t light[2] = {0};
+#if CHIPTUNE_PRERENDERED
+/* Next block of the prerendered stream */
+static CHIPTUNE_TLS uint32_t prerenderblock = 0;
+#endif
 
-/* Audio DMA double buffer */
-static uint16_t audioBuffer[AUDIO_BUFFER_SIZE] __attribute__((aligned(4)));
-static volatile uint32_t bufferIndex = 0;
+/* Register dump replacing the sequencer, NULL when not replaying */
+static CHIPTUNE_TLS const regdump_t *replay = NULL;
+static CHIPTUNE_TLS uint32_t replaypos;    /* next tick record */
+static CHIPTUNE_TLS uint32_t replayticks;  /* ticks applied */
+static CHIPTUNE_TLS uint8_t replayidle;    /* unchanged ticks before the next record */
 
-/* Oscillators */
-volatile oscillator_t osc[4];
+#if CHIPTUNE_OVERSAMPLE > 1
+/* Decimator history, each sample stored twice so the newest DECIM_TAPS
+ * are always contiguous at histpos */
+static CHIPTUNE_TLS int16_t histl[2 * DECIM_TAPS] __attribute__((aligned(4)));
+#if CHIPTUNE_STEREO
+static CHIPTUNE_TLS int16_t histr[2 * DECIM_TAPS] __attribute__((aligned(4)));
+#endif
+static CHIPTUNE_TLS uint16_t histpos;
+#endif
+
+/* Oscillators: the sequencer's registers, then the two copies the mixer
+ * plays (front is the one published) with the channels effects have in
+ * each, and the mixer's own state */
+CHIPTUNE_TLS oscillator_t osc[4];
+static CHIPTUNE_TLS oscillator_t oscbuf[2][CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS uint8_t sfxbuf[2];
+static CHIPTUNE_TLS volatile uint8_t front;
+static CHIPTUNE_TLS voice_t voice[CHIPTUNE_CHANNELS];
+
+/* Mixer state of the music's voices while effects play over them (the
+ * channels in voicesfx), put back when the effect hands the channel back */
+static CHIPTUNE_TLS voice_t musicvoice[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS uint8_t voicesfx;
 
 /* Channels */
-static struct channel channel[4];
+static CHIPTUNE_TLS struct channel channel[4];
+
+/* Profiling counters */
+static CHIPTUNE_TLS volatile chiptune_stats_t stats;
+
+/* Wavetables, read by the mixer every sample */
+static CHIPTUNE_TLS wavetable_t wavetables[WAVETABLE_COUNT] CCMRAM;
+
+/* Samples selectable with command 'k' */
+static CHIPTUNE_TLS const sample_t *samplebank = NULL;
+static CHIPTUNE_TLS uint8_t samplecount = 0;
+
+/* ADPCM decode rings */
+static CHIPTUNE_TLS adpcmring_t adpcmring[CHIPTUNE_CHANNELS] CCMRAM;
 
 /* Resources */
-static uint16_t resources[16 + MAXTRACK];
+static CHIPTUNE_TLS uint32_t resources[16 + SONG_MAX_TRACKS];
 
 /* Song unpacker */
-static struct unpacker songup;
+static CHIPTUNE_TLS struct unpacker songup;
+
+/* Current song: the built-in songdata, an entry of the song bank or a
+ * Chiptune_PlaySong() container */
+static CHIPTUNE_TLS songinfo_t cursong = { songdata, sizeof(songdata), 1, SONG_MAX_INSTRUMENTS, MAXTRACK, SONGLEN };
+static CHIPTUNE_TLS uint8_t songnum = 0;
+
+/* Song bank, and the song to switch to at the next tick */
+#define SONG_NONE              0xFF
+static CHIPTUNE_TLS const uint8_t *songbank = NULL;
+static CHIPTUNE_TLS uint8_t songcount = 0;
+static CHIPTUNE_TLS songinfo_t nextsong;
+static CHIPTUNE_TLS volatile uint8_t pendingsong = SONG_NONE;
+
+/* Control events: posted by the application, taken by the audio interrupt
+ * at their sample, then passed to the sequencer unless they are the
+ * mixer's (mutes), so only those are sample-accurate */
+static CHIPTUNE_TLS evqueue_t postq;
+static CHIPTUNE_TLS evqueue_t tickq;
+
+/* Sound effects: the bank, and per channel the effect borrowing it (NULL
+ * while the music has it) with its priority, instrument state and the
+ * registers published in place of the music's */
+static CHIPTUNE_TLS const chiptune_sfx_t *sfxbank = NULL;
+static CHIPTUNE_TLS uint8_t sfxcount = 0;
+static CHIPTUNE_TLS const chiptune_sfx_t *sfx[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS uint8_t sfxprio[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS struct channel sfxchannel[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS oscillator_t sfxosc[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS uint8_t sfxmask;
+
+/* Live mix controls (Chiptune_SetMute and on): single byte stores from any
+ * context. The mixer reads the mute (also set by CHIPTUNE_EV_MUTE) and
+ * solo masks every sample, the sequencer the rest as it updates the
+ * oscillators. */
+static CHIPTUNE_TLS volatile uint8_t mutemask;
+static CHIPTUNE_TLS volatile uint8_t livesolo;
+static CHIPTUNE_TLS volatile uint8_t livescale[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS volatile int8_t livetranspose;
+
+/* Pitch bend per channel from CHIPTUNE_EV_BEND, 64ths of a semitone */
+static CHIPTUNE_TLS int8_t livebend[CHIPTUNE_CHANNELS];
+
+/* Note velocity per channel from CHIPTUNE_EV_VELOCITY, 255 full */
+static CHIPTUNE_TLS uint8_t livevelocity[CHIPTUNE_CHANNELS];
+
+/* State blob: header, globals, per-oscillator and per-channel records */
+#define STATE_HEADER           6
+#define STATE_GLOBALS          61
+#define STATE_OSC              35
+#define STATE_CHANNEL          31
+/* Offsets of the fields LoadState validates */
+#define STATE_G_LOOP           4
+#define STATE_G_SONGUP         8
+#define STATE_G_REPLAY         31
+#define STATE_G_REPLAYPOS      32
+#define STATE_G_SONG           41
+#define STATE_G_TICKPERIOD     44
+#define STATE_G_RAMPPERIOD     52
+#define STATE_G_RAMPTICKS      56
+#define STATE_G_ROWSPEED       57
+#define STATE_O_TABLE          15
+#define STATE_O_SAMPLE         16
+#define STATE_C_TRACKUP        0
+#define STATE_C_TNUM           6
+#define STATE_C_LASTINSTR      9
+#define STATE_C_INUM           10
+#if CHIPTUNE_OVERSAMPLE > 1
+#define STATE_DECIM            (2 + (CHIPTUNE_STEREO + 1) * DECIM_TAPS * 2)
+#else
+#define STATE_DECIM            0
+#endif
+#define STATE_SIZE             (STATE_HEADER + STATE_GLOBALS + STATE_DECIM + \
+                                CHIPTUNE_CHANNELS * (STATE_OSC + STATE_CHANNEL))
+#define STATE_CONFIG           (CHIPTUNE_STEREO | (CHIPTUNE_OVERSAMPLE << 1))
+
+#if STATE_SIZE > CHIPTUNE_STATE_MAX
+#error "CHIPTUNE_STATE_MAX is too small for this build"
+#endif
+
+#if CHIPTUNE_TEMPO < 1 || CHIPTUNE_TEMPO > 255
+#error "CHIPTUNE_TEMPO is a BPM of 1-255"
+#endif
+
+/* Seek index, one entry per order position */
+static CHIPTUNE_TLS seekpoint_t seekindex[SONG_MAX_ORDERS] CCMRAM;
+static CHIPTUNE_TLS uint8_t seekready = 0;
+static CHIPTUNE_TLS uint8_t looporder = SONG_NO_LOOP;
 
 /* Frequency table */
 static const uint16_t freqtable[] = {
@@ -51,6 +297,40 @@ static const uint16_t freqtable[] = {
     0x70a3, 0x7756, 0x7e6f
 };
 
+/*
+ * Filter cutoff: g = tan(pi fc / fs) in 16.16 at the render rate, fc =
+ * 50 Hz * 72^(i / 32) for 'c' parameters i * 8, interpolated between.
+ */
+#if CHIPTUNE_OVERSAMPLE == 1
+static const uint32_t cutofftable[33] = {
+    0x00507, 0x005bf, 0x00691, 0x00782, 0x00895, 0x009cf, 0x00b37, 0x00cd2,
+    0x00ea8, 0x010c2, 0x0132a, 0x015eb, 0x01912, 0x01caf, 0x020d3, 0x02595,
+    0x02b0d, 0x03159, 0x0389e, 0x04109, 0x04ad3, 0x05643, 0x063bb, 0x073be,
+    0x08703, 0x09e9f, 0x0bc3d, 0x0e2aa, 0x116f9, 0x1638b, 0x1e17f, 0x2e1e8,
+    0x65052
+};
+#elif CHIPTUNE_OVERSAMPLE == 2
+static const uint32_t cutofftable[33] = {
+    0x00283, 0x002df, 0x00349, 0x003c1, 0x0044a, 0x004e7, 0x0059b, 0x00668,
+    0x00753, 0x0085f, 0x00992, 0x00af0, 0x00c81, 0x00e4c, 0x01059, 0x012b1,
+    0x01560, 0x01873, 0x01bf9, 0x02002, 0x024a5, 0x029f9, 0x0301b, 0x0372e,
+    0x03f5f, 0x048e2, 0x053fd, 0x0610c, 0x07089, 0x08321, 0x099d3, 0x0b628,
+    0x0daa5
+};
+#else
+static const uint32_t cutofftable[33] = {
+    0x00142, 0x00170, 0x001a4, 0x001e0, 0x00225, 0x00274, 0x002cd, 0x00334,
+    0x003a9, 0x0042f, 0x004c8, 0x00578, 0x00640, 0x00725, 0x0082a, 0x00955,
+    0x00aab, 0x00c32, 0x00df2, 0x00ff1, 0x0123b, 0x014d9, 0x017d8, 0x01b47,
+    0x01f37, 0x023bb, 0x028ec, 0x02ee5, 0x035c8, 0x03dc0, 0x046ff, 0x051c8,
+    0x05e72
+};
+#endif
+
+/* Filter damping k, 16.16: sqrt(2) at resonance 0, no peak, down to 0.1 */
+#define SVF_DAMP               92682
+#define SVF_DAMP_STEP          5742
+
 /* Sine table for vibrato */
 static const int8_t sinetable[] = {
     0, 12, 25, 37, 49, 60, 71, 81, 90, 98, 106, 112, 117, 122, 125, 126,
@@ -60,26 +340,91 @@ static const int8_t sinetable[] = {
     -71, -60, -49, -37, -25, -12
 };
 
-static const uint8_t validcmds[] = "0dfijlmtvw~+=";
+/*
+ * PolyBLEP residual for a unit half-step, scaled to the 63-level waveform
+ * swing: 31.5 * (1 - (j + 0.5) / BLEP_LEN)^2, j = distance from the edge
+ * in BLEP_LEN-ths of one sample period.
+ */
+#if CHIPTUNE_OVERSAMPLE == 1
+static const int8_t bleptable[BLEP_LEN] = {
+    31, 29, 27, 25, 23, 22, 20, 18, 17, 16, 14, 13, 12, 11, 9, 8,
+    7, 6, 6, 5, 4, 3, 3, 2, 2, 1, 1, 1, 0, 0, 0, 0
+};
+#endif
+
+static const uint8_t validcmds[] = CHIPTUNE_COMMANDS;
 
 /* Private function prototypes */
-static uint8_t readsongbyte(uint16_t offset);
-static void initup(struct unpacker *up, uint16_t offset);
+static uint8_t readsongbyte(uint32_t offset);
+static void initup(struct unpacker *up, uint32_t offset);
 static uint8_t readbit(struct unpacker *up);
 static uint16_t readchunk(struct unpacker *up, uint8_t n);
 static void readinstr(uint8_t num, uint8_t pos, uint8_t *dest);
-static void runcmd(uint8_t ch, uint8_t cmd, uint8_t param);
+static uint8_t clampnote(int16_t note);
+static uint16_t notefreq(uint8_t note, int16_t pitch);
+static void runcmd(struct channel *c, oscillator_t *o, uint8_t cmd, uint8_t param);
+static void stepchannel(struct channel *c, oscillator_t *o, const chiptune_sfx_t *sfx, int16_t pitch);
 static void playroutine(void);
 static void initresources(void);
+static void resetsequencer(void);
+static uint32_t rdle(const uint8_t *p, uint8_t size);
+static HAL_StatusTypeDef songcontainer(const uint8_t *base, uint32_t bytes, songinfo_t *song);
+static HAL_StatusTypeDef songentry(uint8_t num, songinfo_t *song);
+static void loadsong(const songinfo_t *song, uint8_t num);
+static void savepoint(seekpoint_t *sp);
+static void loadpoint(const seekpoint_t *sp);
+static void wr8(uint8_t **p, uint8_t v);
+static void wr16(uint8_t **p, uint16_t v);
+static void wr32(uint8_t **p, uint32_t v);
+static uint8_t rd8(const uint8_t **p);
+static uint16_t rd16(const uint8_t **p);
+static uint32_t rd32(const uint8_t **p);
+static uint8_t songoffsetok(const uint8_t *p, uint32_t bytes);
+static uint8_t periodok(const uint8_t *p);
+static void replaytick(void);
+static uint8_t evpush(evqueue_t *q, const chiptune_event_t *e);
+static const chiptune_event_t *evpeek(evqueue_t *q);
+static void evpop(evqueue_t *q);
+static void takeevents(void);
+static void applyevent(const chiptune_event_t *e);
+static void runevents(void);
+static void runlive(void);
+static void triggerinstr(uint8_t ch, uint8_t instr);
+#if CHIPTUNE_STEREO
+static uint32_t stereogain(uint8_t volume, uint8_t pan);
+#endif
+static uint32_t packgain(uint8_t volume, uint8_t pan);
+static uint32_t mixgain(uint8_t ch, const oscillator_t *o, uint8_t velocity);
+static void startsfx(const chiptune_event_t *e);
+static void sfxtick(void);
+static uint32_t noiseblock(uint32_t seed);
+#if CHIPTUNE_OVERSAMPLE == 1
+static int8_t blepcorrect(const oscillator_t *o, voice_t *v, uint16_t phase);
+#endif
+static void publish(void);
+static void svfcoef(oscillator_t *o);
+static inline int32_t svfrun(const oscillator_t *o, voice_t *vc, int32_t x);
+static inline mix_t finemix(int32_t v, uint32_t gain);
+static void swapvoices(uint8_t sfx);
+static inline mix_t mixvoices(const oscillator_t *o, uint8_t sub);
+static inline int16_t samplevalue(uint8_t ch, const oscillator_t *o, uint8_t sub);
+static void adpcmfill(adpcmring_t *r, const sample_t *s, uint32_t block);
+static inline int16_t adpcmframe(uint8_t ch, const sample_t *s, uint32_t pos, uint32_t end);
+#if CHIPTUNE_OVERSAMPLE > 1
+static inline void decimpush(mix_t s);
+static inline int16_t firdecim(const int16_t *x);
+static inline mix_t decimate(void);
+#endif
 
 /* Private functions ---------------------------------------------------------*/
 
-static uint8_t readsongbyte(uint16_t offset)
+/* Past the end reads as 0, so a corrupt offset cannot leave the song */
+static uint8_t readsongbyte(uint32_t offset)
 {
-    return songdata[offset];
+    return offset < cursong.bytes ? cursong.base[offset] : 0;
 }
 
-static void initup(struct unpacker *up, uint16_t offset)
+static void initup(struct unpacker *up, uint32_t offset)
 {
     up->nextbyte = offset;
     up->bits = 0;
@@ -118,82 +463,663 @@ static uint16_t readchunk(struct unpacker *up, uint8_t n)
     return val;
 }
 
+#if CHIPTUNE_STEREO
+/*
+ * Pack the left/right volumes of a voice into one word so the mixer can
+ * scale both lanes with a single multiply-accumulate. Balance law: the
+ * side being panned towards stays at full volume, so PAN_CENTER yields
+ * exactly the mono volume in both lanes. The law is symmetric about
+ * PAN_CENTER: the other lane falls over 127 steps each way, to silence at
+ * PAN_RIGHT and at 0x01, so PAN_LEFT and 0x01 are both hard left.
+ */
+static uint32_t stereogain(uint8_t volume, uint8_t pan)
+{
+    uint8_t d = (pan > PAN_CENTER) ? pan - PAN_CENTER : PAN_CENTER - pan;
+    uint16_t g, gl, gr;
+
+    if(d > PAN_RIGHT - PAN_CENTER) d = PAN_RIGHT - PAN_CENTER;
+    g = ((PAN_RIGHT - PAN_CENTER - d) * 128 + 63) / (PAN_RIGHT - PAN_CENTER);
+    gl = (pan > PAN_CENTER) ? g : 128;
+    gr = (pan < PAN_CENTER) ? g : 128;
+
+    return ((volume * gl) >> 7) | (((volume * gr) >> 7) << 16);
+}
+#endif
+
+/*
+ * Gain the mixer plays channel ch's voice o at, the music's or an
+ * effect's: its volume register through the channel's live volume scale
+ * and a note velocity, so the register itself stays as the song left it.
+ * A scale or velocity of 255 passes the volume through unchanged. Mute and
+ * solo are the mixer's.
+ */
+static uint32_t mixgain(uint8_t ch, const oscillator_t *o, uint8_t velocity)
+{
+    uint8_t scale = livescale[ch];
+    uint32_t volume = (o->volume * (scale + (scale >> 7))) >> 8;
+
+    return packgain((volume * (velocity + (velocity >> 7))) >> 8, o->pan);
+}
+
+/* Gain word the mixer reads for a volume and pan */
+static uint32_t packgain(uint8_t volume, uint8_t pan)
+{
+#if CHIPTUNE_STEREO
+    return stereogain(volume, pan);
+#else
+    (void)pan;
+    return volume;
+#endif
+}
+
+/*
+ * Advance the noise LFSR (taps 31, 24, 9, 6) by 32 steps at once and
+ * return the resulting seed. Its bits, MSB first, are the next 32 bits
+ * shifted into noiseseed. Every new bit is the XOR of the bits 32, 25,
+ * 10 and 7 positions back, so the old seed supplies the first term
+ * directly and the rest follow from a fixed point that resolves at
+ * least 7 bits per pass: 4 passes settle all 32.
+ */
+static uint32_t noiseblock(uint32_t seed)
+{
+    uint32_t t = seed ^ (seed << 7) ^ (seed << 22) ^ (seed << 25);
+    uint32_t n = t;
+
+    n = t ^ (n >> 25) ^ (n >> 10) ^ (n >> 7);
+    n = t ^ (n >> 25) ^ (n >> 10) ^ (n >> 7);
+    n = t ^ (n >> 25) ^ (n >> 10) ^ (n >> 7);
+    n = t ^ (n >> 25) ^ (n >> 10) ^ (n >> 7);
+
+    return n;
+}
+
+/*
+ * PolyBLEP correction for the saw and pulse discontinuities: only samples
+ * within one phase increment of an edge are touched, each by one table
+ * lookup. Result stays inside the -32..31 waveform range, so the mixer
+ * headroom is unchanged.
+ */
+#if CHIPTUNE_OVERSAMPLE == 1
+static int8_t blepcorrect(const oscillator_t *o, voice_t *v, uint16_t phase)
+{
+    uint16_t freq = o->freq;
+    uint32_t rcp;
+    uint16_t d;
+    int8_t corr = 0;
+
+    /* Above half the sample rate the edges overlap: leave it naive */
+    if(!freq || freq >= 0x8000) return 0;
+
+    if(freq != v->blepfreq)
+    {
+        v->blepfreq = freq;
+        v->bleprcp = (BLEP_LEN << 16) / freq;
+    }
+    rcp = v->bleprcp;
+
+    /* Wrap edge: falling for saw, rising for pulse */
+    d = -phase;
+    if(phase < freq) corr = bleptable[(phase * rcp) >> 16];
+    else if(d < freq) corr = -bleptable[(d * rcp) >> 16];
+
+    if(o->waveform == WF_PUL)
+    {
+        uint16_t duty = o->duty;
+
+        corr = -corr;
+
+        /* Falling edge at duty */
+        if(phase > duty)
+        {
+            d = phase - duty;
+            if(d < freq) corr += bleptable[(d * rcp) >> 16];
+        }
+        else
+        {
+            d = duty - phase;
+            if(d < freq) corr -= bleptable[(d * rcp) >> 16];
+        }
+    }
+
+    return corr;
+}
+#endif /* CHIPTUNE_OVERSAMPLE == 1 */
+
 static void readinstr(uint8_t num, uint8_t pos, uint8_t *dest)
 {
     dest[0] = readsongbyte(resources[num] + 2 * pos + 0);
     dest[1] = readsongbyte(resources[num] + 2 * pos + 1);
 }
 
-static void runcmd(uint8_t ch, uint8_t cmd, uint8_t param)
+static void triggerinstr(uint8_t ch, uint8_t instr)
+{
+    channel[ch].lastinstr = instr;
+    channel[ch].inum = instr;
+    channel[ch].iptr = 0;
+    channel[ch].iwait = 0;
+    channel[ch].bend = 0;
+    channel[ch].bendd = 0;
+    channel[ch].volumed = 0;
+    channel[ch].dutyd = 0;
+    channel[ch].vdepth = 0;
+}
+
+/* Samples per tick at 'bpm', 16.16 */
+static uint32_t tempoperiod(uint8_t bpm)
+{
+    return ((uint32_t)CHIPTUNE_SAMPLE_RATE * 5 / 2 << 16) / bpm;
+}
+
+/* New tempo, reached in 'ramp' equal steps of the period, one per tick */
+static void settempo(uint8_t bpm, uint8_t ramp)
+{
+    rampperiod = tempoperiod(bpm);
+    rampticks = ramp;
+    if(ramp) tickstep = ((int32_t)rampperiod - (int32_t)tickperiod) / ramp;
+    else tickperiod = rampperiod;
+}
+
+/* Due time of the next tick, and the ramp's step for it */
+static void scheduletick(void)
+{
+    uint32_t frac = tickfrac + (tickperiod & 0xffff);
+
+    nexttick += (tickperiod >> 16) + (frac >> 16);
+    tickfrac = (uint16_t)frac;
+    if(rampticks) tickperiod = --rampticks ? tickperiod + tickstep : rampperiod;
+}
+
+/*
+ * Borrow a channel for an effect: of those it may use, a free one where
+ * the music is quietest, else the one playing the lowest priority effect
+ * if that is not above this one. The effect plays from this tick.
+ */
+static void startsfx(const chiptune_event_t *e)
+{
+    const chiptune_sfx_t *fx;
+    uint16_t key, bestkey = 0xffff;
+    uint8_t ch, best = CHIPTUNE_CHANNELS;
+    uint32_t late = audioTicks - e->time;
+
+    if(e->value >= sfxcount) return;
+    fx = &sfxbank[e->value];
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+    {
+        if(!(fx->channels & (1 << ch))) continue;
+        if(!sfx[ch]) key = osc[ch].volume;
+        else if(sfxprio[ch] <= e->ch) key = 0x100 + sfxprio[ch];
+        else continue;
+        if(key < bestkey)
+        {
+            bestkey = key;
+            best = ch;
+        }
+    }
+    if(best == CHIPTUNE_CHANNELS)
+    {
+        stats.sfxdropped++;
+        return;
+    }
+    if((int32_t)late > 0 && late > stats.sfxlatency) stats.sfxlatency = late;
+
+    memset(&sfxchannel[best], 0, sizeof(sfxchannel[best]));
+    sfxchannel[best].inum = 1;    /* running; the program comes from fx */
+    sfxchannel[best].tnote = sfxchannel[best].inote = clampnote(e->arg);
+    sfxosc[best].freq = 0;
+    sfxosc[best].duty = 0x8000;
+    sfxosc[best].waveform = WF_TRI;
+    sfxosc[best].volume = 0;
+    sfxosc[best].pan = PAN_CENTER;
+    sfxosc[best].trigger = osc[best].trigger;
+    sfxosc[best].gain = 0;
+    sfxosc[best].table = &wavetables[0];
+    sfxosc[best].sample = NULL;
+    sfxosc[best].sstep = 0;
+    sfxosc[best].cutoff = 0xff;
+    sfxosc[best].filter = 0;
+    sfx[best] = fx;
+    sfxprio[best] = e->ch;
+    sfxmask |= 1 << best;
+}
+
+/*
+ * Effects step after the music, which carries on underneath: an effect
+ * that ends hands its channel back at the music's current registers.
+ * They replace voices rather than add them, so the mixer's cost is the
+ * same with or without.
+ */
+static void sfxtick(void)
+{
+    uint8_t ch;
+
+    for(ch = 0; sfxmask >> ch; ch++)
+    {
+        if(!sfx[ch]) continue;
+        stepchannel(&sfxchannel[ch], &sfxosc[ch], sfx[ch], 0);
+        /* Effects play at full velocity */
+        sfxosc[ch].gain = mixgain(ch, &sfxosc[ch], 255);
+        if(!sfxchannel[ch].inum)
+        {
+            sfx[ch] = NULL;
+            sfxmask &= ~(1 << ch);
+        }
+    }
+}
+
+/*
+ * Hand the registers to the mixer: they are copied whole into the buffer
+ * it is not reading, then one byte store switches it over, so the audio
+ * interrupt never mixes a voice the sequencer is halfway through.
+ */
+static void publish(void)
+{
+    uint8_t back = front ^ 1;
+    uint8_t ch;
+
+    memcpy(oscbuf[back], osc, sizeof(osc));
+    for(ch = 0; sfxmask >> ch; ch++)
+    {
+        if(sfxmask & (1 << ch)) oscbuf[back][ch] = sfxosc[ch];
+    }
+    sfxbuf[back] = sfxmask;
+    __DMB();
+    front = back;
+}
+
+/*
+ * Filter coefficients from the 'c' and 'q' registers, when a command sets
+ * them: at tick rate, never per sample. g from cutofftable and the
+ * damping k give the integrator gains a1 = 1 / (1 + g (g + k)), a2 = g a1
+ * and a3 = g a2 in Q15, paired as svfrun() multiplies them, then the mode
+ * mix in Q14. The high-pass output x - k v1 - v2 folds into the band-pass
+ * (v1) and low-pass (v2) weights; its x term is added by svfrun().
+ */
+static void svfcoef(oscillator_t *o)
+{
+    uint8_t i = o->cutoff >> 3;
+    uint32_t g = cutofftable[i] + (((cutofftable[i + 1] - cutofftable[i]) * (o->cutoff & 7)) >> 3);
+    uint32_t k = SVF_DAMP - (o->filter >> 4) * SVF_DAMP_STEP;
+    uint32_t a1 = (1u << 31) / (65536 + (uint32_t)(((uint64_t)g * (g + k)) >> 16));
+    uint32_t a2, a3;
+    int16_t bp = 0, lp = 0;
+
+    if(a1 > 32767) a1 = 32767;
+    a2 = ((uint64_t)g * a1) >> 16;
+    a3 = ((uint64_t)g * a2) >> 16;
+    if(o->filter & FILTER_BP) bp = 16384;
+    if(o->filter & FILTER_LP) lp = 16384;
+    if(o->filter & FILTER_HP)
+    {
+        bp -= k >> 2;
+        lp -= 16384;
+    }
+
+    o->svf[0] = a1 | (a2 << 16);
+    o->svf[1] = a2 | (a3 << 16);
+    o->svf[2] = (uint16_t)bp | ((uint32_t)(uint16_t)lp << 16);
+}
+
+/*
+ * Event rings. The producer fills a slot before publishing it with head,
+ * the consumer reads it before freeing it with tail; the barriers keep
+ * those orders, so neither side ever masks interrupts.
+ */
+static uint8_t evpush(evqueue_t *q, const chiptune_event_t *e)
+{
+    uint8_t head = q->head;
+
+    if(((head + 1) & (CHIPTUNE_EVENTS - 1)) == q->tail) return 0;
+    q->ev[head] = *e;
+    __DMB();
+    q->head = (head + 1) & (CHIPTUNE_EVENTS - 1);
+
+    return 1;
+}
+
+static const chiptune_event_t *evpeek(evqueue_t *q)
 {
+    if(q->tail == q->head) return NULL;
+    __DMB();
+
+    return &q->ev[q->tail];
+}
+
+static void evpop(evqueue_t *q)
+{
+    __DMB();
+    q->tail = (q->tail + 1) & (CHIPTUNE_EVENTS - 1);
+}
+
+/* Audio interrupt: applies or forwards the events due at this sample */
+static void takeevents(void)
+{
+    const chiptune_event_t *e;
+
+    while((e = evpeek(&postq)) != NULL && (int32_t)(e->time - audioTicks) <= 0)
+    {
+        if(e->type == CHIPTUNE_EV_MUTE) mutemask = e->value;
+        /* A full tick ring keeps the event here for the next sample */
+        else if(!evpush(&tickq, e)) break;
+        evpop(&postq);
+    }
+}
+
+/* Applies one event the audio interrupt passed on to the sequencer */
+static void applyevent(const chiptune_event_t *e)
+{
+    if(e->type & CHIPTUNE_EV_NOW)
+    {
+        /* Live input: how long it waited for the main loop */
+        uint32_t late = audioTicks - e->time;
+
+        if((int32_t)late > 0 && late > stats.livelatency) stats.livelatency = late;
+    }
+
+    switch(e->type & ~CHIPTUNE_EV_NOW)
+    {
+    case CHIPTUNE_EV_NOTE_ON:
+        channel[e->ch].tnote = e->value;
+        triggerinstr(e->ch, e->arg);
+        break;
+    case CHIPTUNE_EV_NOTE_OFF:
+        channel[e->ch].inum = 0;
+        channel[e->ch].volumed = 0;
+        osc[e->ch].volume = 0;
+        break;
+    case CHIPTUNE_EV_SONG:
+        Chiptune_SelectSong(e->value);
+        break;
+    case CHIPTUNE_EV_TEMPO:
+        settempo(e->value, e->arg);
+        break;
+    case CHIPTUNE_EV_SPEED:
+        rowspeed = e->value;
+        break;
+    case CHIPTUNE_EV_SFX:
+        startsfx(e);
+        break;
+    case CHIPTUNE_EV_VOLUME:
+        livescale[e->ch] = e->value;
+        break;
+    case CHIPTUNE_EV_BEND:
+        livebend[e->ch] = (int8_t)e->value;
+        break;
+    case CHIPTUNE_EV_VELOCITY:
+        livevelocity[e->ch] = e->value;
+        break;
+    case CHIPTUNE_EV_COMMAND:
+        runcmd(&channel[e->ch], &osc[e->ch], e->value, e->arg);
+        break;
+    }
+}
+
+/* Sequencer tick: applies the events the audio interrupt passed on */
+static void runevents(void)
+{
+    const chiptune_event_t *e;
+
+    while((e = evpeek(&tickq)) != NULL)
+    {
+        applyevent(e);
+        evpop(&tickq);
+    }
+}
+
+/*
+ * Main loop poll between ticks: applies the CHIPTUNE_EV_NOW events at the
+ * head of the tick ring and publishes the channels they changed, a note
+ * running its instrument's first tick here; the next tick steps it on as
+ * usual. An event left for the tick holds back those behind it, so they
+ * keep the order they were posted in.
+ */
+static void runlive(void)
+{
+    const chiptune_event_t *e;
+
+    while((e = evpeek(&tickq)) != NULL && (e->type & CHIPTUNE_EV_NOW))
+    {
+        uint8_t type = e->type & ~CHIPTUNE_EV_NOW;
+        uint8_t ch = e->ch;
+        int16_t pitch = livetranspose * 64 + livebend[ch];
+
+        /* Only channel events are posted with CHIPTUNE_EV_NOW */
+        applyevent(e);
+        evpop(&tickq);
+        if(replay) continue;
+
+        if(type == CHIPTUNE_EV_NOTE_ON)
+        {
+            stepchannel(&channel[ch], &osc[ch], NULL, pitch);
+        }
+        else if(type == CHIPTUNE_EV_BEND)
+        {
+            /* Moves the pitch by the change in bend; the next tick derives
+             * it afresh */
+            osc[ch].freq += notefreq(channel[ch].inote, livetranspose * 64 + livebend[ch]) -
+                            notefreq(channel[ch].inote, pitch);
+            if(osc[ch].waveform == WF_SAMPLE && osc[ch].sample)
+            {
+                osc[ch].sstep = ((uint32_t)osc[ch].freq << SAMPLE_FRAC_BITS) / osc[ch].sample->basefreq;
+            }
+        }
+        osc[ch].gain = mixgain(ch, &osc[ch], livevelocity[ch]);
+    }
+    publish();
+}
+
+/* Notes past the table, from a bad song or transpose, play the top one */
+static uint8_t clampnote(int16_t note)
+{
+    if(note < 0) return 0;
+    if(note >= (int16_t)(sizeof(freqtable) / sizeof(freqtable[0]))) return sizeof(freqtable) / sizeof(freqtable[0]) - 1;
+    return note;
+}
+
+/* Frequency of a note moved by 'pitch' 64ths of a semitone, interpolated
+ * between the table's semitones */
+static uint16_t notefreq(uint8_t note, int16_t pitch)
+{
+    int16_t p = note * 64 + pitch;
+    uint16_t f;
+    uint8_t n;
+
+    if(!pitch) return freqtable[note];
+    n = clampnote(p >> 6);
+    f = freqtable[n];
+    if(p > 0 && (p & 63) && n + 1u < sizeof(freqtable) / sizeof(freqtable[0]))
+    {
+        f += ((freqtable[n + 1] - f) * (p & 63)) >> 6;
+    }
+
+    return f;
+}
+
+static void runcmd(struct channel *c, oscillator_t *o, uint8_t cmd, uint8_t param)
+{
+    /* Instrument bytes are not range checked when loaded: a command past
+     * the list ends the instrument */
+    if(cmd >= sizeof(validcmds) - 1) cmd = 0;
+
     switch(validcmds[cmd])
     {
     case '0':
-        channel[ch].inum = 0;
+        c->inum = 0;
         break;
     case 'd':
-        osc[ch].duty = param << 8;
+        o->duty = param << 8;
         break;
     case 'f':
-        channel[ch].volumed = param;
+        c->volumed = param;
         break;
     case 'i':
-        channel[ch].inertia = param << 1;
+        c->inertia = param << 1;
         break;
     case 'j':
-        channel[ch].iptr = param;
+        c->iptr = param;
         break;
     case 'l':
-        channel[ch].bendd = param;
+        c->bendd = param;
         break;
     case 'm':
-        channel[ch].dutyd = param << 6;
+        c->dutyd = param << 6;
         break;
     case 't':
-        channel[ch].iwait = param;
+        c->iwait = param;
         break;
     case 'v':
-        osc[ch].volume = param;
+        o->volume = param;
         break;
     case 'w':
-        osc[ch].waveform = param;
+        o->waveform = param;
         break;
     case '+':
-        channel[ch].inote = param + channel[ch].tnote - 12 * 4;
+        c->inote = clampnote(param + c->tnote - 12 * 4);
         break;
     case '=':
-        channel[ch].inote = param;
+        c->inote = clampnote(param);
+        break;
+    case 'p':
+        o->pan = param;
+        break;
+    case 'x':
+        o->table = &wavetables[param % WAVETABLE_COUNT];
+        break;
+    case 'c':
+        o->cutoff = param;
+        svfcoef(o);
+        break;
+    case 'q':
+        o->filter = param;
+        svfcoef(o);
+        break;
+    case 'k':
+        /* Select and retrigger */
+        o->sample = (param < samplecount) ? &samplebank[param] : NULL;
+        o->trigger++;
         break;
     case '~':
-        if(channel[ch].vdepth != (param >> 4))
+        if(c->vdepth != (param >> 4))
         {
-            channel[ch].vpos = 0;
+            c->vpos = 0;
         }
-        channel[ch].vdepth = param >> 4;
-        channel[ch].vrate = param & 15;
+        c->vdepth = param >> 4;
+        c->vrate = param & 15;
         break;
     }
 }
 
+/*
+ * One tick of a channel: runs its instrument program up to a wait, then
+ * derives the oscillator registers from the slides, vibrato and note. A
+ * sound effect reads its program from the effect rather than the song.
+ */
+static void stepchannel(struct channel *c, oscillator_t *o, const chiptune_sfx_t *sfx, int16_t pitch)
+{
+    int16_t vol;
+    uint16_t duty;
+    uint16_t slur;
+    uint16_t target;
+    uint8_t budget = CHIPTUNE_INSTR_BUDGET;
+
+    while(c->inum && !c->iwait)
+    {
+        uint8_t il[2];
+
+        if(!budget--)
+        {
+            stats.overruns++;
+            break;
+        }
+
+        if(!sfx)
+        {
+            readinstr(c->inum, c->iptr, il);
+        }
+        else if(c->iptr < sfx->length)
+        {
+            il[0] = sfx->program[2 * c->iptr];
+            il[1] = sfx->program[2 * c->iptr + 1];
+        }
+        else
+        {
+            /* Past its last line an effect stops */
+            il[0] = il[1] = 0;
+        }
+        c->iptr++;
+
+        runcmd(c, o, il[0], il[1]);
+    }
+    if(c->iwait) c->iwait--;
+
+    /* The live transpose and bend shift the pitch, not the channel's note */
+    target = notefreq(c->inote, pitch);
+    if(c->inertia)
+    {
+        int16_t diff;
+
+        slur = c->slur;
+        diff = target - slur;
+        if(diff > 0)
+        {
+            if(diff > c->inertia) diff = c->inertia;
+        }
+        else if(diff < 0)
+        {
+            if(diff < -c->inertia) diff = -c->inertia;
+        }
+        slur += diff;
+        c->slur = slur;
+    }
+    else
+    {
+        slur = target;
+    }
+    o->freq =
+        slur +
+        c->bend +
+        ((c->vdepth * sinetable[c->vpos & 63]) >> 2);
+    c->bend += c->bendd;
+    vol = o->volume + c->volumed;
+    if(vol < 0) vol = 0;
+    if(vol > 255) vol = 255;
+    o->volume = vol;
+    if(o->waveform == WF_SAMPLE && o->sample)
+    {
+        o->sstep = ((uint32_t)o->freq << SAMPLE_FRAC_BITS) / o->sample->basefreq;
+    }
+
+    duty = o->duty + c->dutyd;
+    if(duty > 0xe000) duty = 0x2000;
+    if(duty < 0x2000) duty = 0xe000;
+    o->duty = duty;
+
+    c->vpos += c->vrate;
+}
+
 static void playroutine(void)
 {
+    int8_t transpose = livetranspose;
     uint8_t ch;
 
     if(playsong)
     {
-        if(trackwait)
+        if(trackwait >= 16)
         {
-            trackwait--;
+            trackwait -= 16;
         }
         else
         {
-            trackwait = 4;
-
             if(!trackpos)
             {
                 if(playsong)
                 {
-                    if(songpos >= SONGLEN)
+                    if(songpos >= cursong.orders && looporder < cursong.orders && seekready)
+                    {
+                        /* Only the order cursor jumps, voices carry on */
+                        songup = seekindex[looporder].songup;
+                        songpos = looporder;
+                    }
+                    if(songpos >= cursong.orders)
                     {
                         playsong = 0;
                     }
@@ -267,80 +1193,30 @@ static void playroutine(void)
                             {
                                 light[0] = light[1] = 30;
                             }
-                            channel[ch].lastinstr = instr;
-                            channel[ch].inum = instr;
-                            channel[ch].iptr = 0;
-                            channel[ch].iwait = 0;
-                            channel[ch].bend = 0;
-                            channel[ch].bendd = 0;
-                            channel[ch].volumed = 0;
-                            channel[ch].dutyd = 0;
-                            channel[ch].vdepth = 0;
+                            triggerinstr(ch, instr);
                         }
-                        if(cmd) runcmd(ch, cmd, param);
+                        if(validcmds[cmd] == 't' && cursong.version >= SONG_VERSION_SPEED)
+                        {
+                            rowspeed = param < 0x10 ? 0x10 : param;
+                        }
+                        else if(cmd) runcmd(&channel[ch], &osc[ch], cmd, param);
                     }
                 }
 
                 trackpos++;
                 trackpos &= 31;
             }
+
+            /* Rows start every rowspeed / 16 ticks, carrying the fraction;
+             * a speed set on this row already times it */
+            trackwait += rowspeed - 16;
         }
     }
 
     for(ch = 0; ch < 4; ch++)
     {
-        int16_t vol;
-        uint16_t duty;
-        uint16_t slur;
-
-        while(channel[ch].inum && !channel[ch].iwait)
-        {
-            uint8_t il[2];
-
-            readinstr(channel[ch].inum, channel[ch].iptr, il);
-            channel[ch].iptr++;
-
-            runcmd(ch, il[0], il[1]);
-        }
-        if(channel[ch].iwait) channel[ch].iwait--;
-
-        if(channel[ch].inertia)
-        {
-            int16_t diff;
-
-            slur = channel[ch].slur;
-            diff = freqtable[channel[ch].inote] - slur;
-            if(diff > 0)
-            {
-                if(diff > channel[ch].inertia) diff = channel[ch].inertia;
-            }
-            else if(diff < 0)
-            {
-                if(diff < -channel[ch].inertia) diff = -channel[ch].inertia;
-            }
-            slur += diff;
-            channel[ch].slur = slur;
-        }
-        else
-        {
-            slur = freqtable[channel[ch].inote];
-        }
-        osc[ch].freq =
-            slur +
-            channel[ch].bend +
-            ((channel[ch].vdepth * sinetable[channel[ch].vpos & 63]) >> 2);
-        channel[ch].bend += channel[ch].bendd;
-        vol = osc[ch].volume + channel[ch].volumed;
-        if(vol < 0) vol = 0;
-        if(vol > 255) vol = 255;
-        osc[ch].volume = vol;
-
-        duty = osc[ch].duty + channel[ch].dutyd;
-        if(duty > 0xe000) duty = 0x2000;
-        if(duty < 0x2000) duty = 0xe000;
-        osc[ch].duty = duty;
-
-        channel[ch].vpos += channel[ch].vrate;
+        stepchannel(&channel[ch], &osc[ch], NULL, transpose * 64 + livebend[ch]);
+        osc[ch].gain = mixgain(ch, &osc[ch], livevelocity[ch]);
     }
 
     /* Update LEDs using HAL */
@@ -357,135 +1233,1570 @@ static void playroutine(void)
     }
 }
 
-static void initresources(void)
+/*
+ * playroutine replacement: applies one tick of the register dump. Reads at
+ * most REGDUMP_MAX_TICK bytes, so its cost is bounded and independent of
+ * the song.
+ */
+static void replaytick(void)
 {
-    uint8_t i;
+    const uint8_t *p;
+    uint8_t mask, ch;
+
+    /* Every tick, idle or not, so the live mix controls apply as with the
+     * sequencer */
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+    {
+        osc[ch].gain = mixgain(ch, &osc[ch], livevelocity[ch]);
+    }
+
+    replayticks++;
+    if(replayidle)
+    {
+        replayidle--;
+        return;
+    }
+    if(replaypos >= replay->length) return;
+
+    p = &replay->data[replaypos];
+    mask = *p++;
+    replayidle = mask >> 4;
+
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+    {
+        uint8_t f;
+
+        if(!(mask & (1 << ch))) continue;
+
+        f = *p++;
+        if(f & REGDUMP_FREQ)
+        {
+            osc[ch].freq = p[0] | (p[1] << 8);
+            p += 2;
+        }
+        if(f & REGDUMP_FREQ_DELTA) osc[ch].freq += (int8_t)*p++;
+        if(f & REGDUMP_DUTY)
+        {
+            osc[ch].duty = p[0] | (p[1] << 8);
+            p += 2;
+        }
+        if(f & REGDUMP_WAVEFORM) osc[ch].waveform = *p++;
+        if(f & REGDUMP_VOLUME) osc[ch].volume = *p++;
+        if(f & REGDUMP_PAN) osc[ch].pan = *p++;
+        if(f & REGDUMP_TABLE) osc[ch].table = &wavetables[*p++ % WAVETABLE_COUNT];
+        if(f & REGDUMP_SAMPLE)
+        {
+            osc[ch].sample = (*p < samplecount) ? &samplebank[*p] : NULL;
+            osc[ch].trigger++;
+            p++;
+        }
+
+        /* Derived state, as playroutine computes it */
+        if(f & (REGDUMP_VOLUME | REGDUMP_PAN))
+        {
+            osc[ch].gain = mixgain(ch, &osc[ch], livevelocity[ch]);
+        }
+        if(osc[ch].waveform == WF_SAMPLE && osc[ch].sample)
+        {
+            osc[ch].sstep = ((uint32_t)osc[ch].freq << SAMPLE_FRAC_BITS) / osc[ch].sample->basefreq;
+        }
+    }
+
+    replaypos = p - replay->data;
+}
+
+/*
+ * Resource offsets. Instruments and tracks the song does not have point
+ * past its end and read as zeros: the instruments stop at once and the
+ * tracks are empty, whatever the order list refers to.
+ */
+static void initresources(void)
+{
+    const uint8_t *t = cursong.base + SONG_HEADER;
+    uint8_t size = cursong.base[3];
+    uint8_t i;
     struct unpacker up;
 
-    initup(&up, 0);
-    for(i = 0; i < 16 + MAXTRACK; i++)
+    if(cursong.version == 1)
+    {
+        initup(&up, 0);
+        for(i = 0; i < 16 + cursong.tracks; i++)
+        {
+            resources[i] = readchunk(&up, 13);
+        }
+    }
+    else
+    {
+        resources[0] = rdle(t, size);
+        for(i = 1; i < 16; i++)
+        {
+            resources[i] = i <= cursong.instruments ? rdle(t + i * size, size) : cursong.bytes;
+        }
+        for(i = 0; i < cursong.tracks; i++)
+        {
+            resources[16 + i] = rdle(t + (1 + cursong.instruments + i) * size, size);
+        }
+    }
+    for(i = 16 + cursong.tracks; i < 16 + SONG_MAX_TRACKS; i++)
     {
-        resources[i] = readchunk(&up, 13);
+        resources[i] = cursong.bytes;
     }
 
     initup(&songup, resources[0]);
 }
 
-/* Public functions ----------------------------------------------------------*/
+/* Little endian value of 'size' bytes */
+static uint32_t rdle(const uint8_t *p, uint8_t size)
+{
+    uint32_t v = 0;
 
-void Chiptune_Init(void)
+    while(size--) v = (v << 8) | p[size];
+
+    return v;
+}
+
+/* Check a version 2 or 3 container and take its counts from the header */
+static HAL_StatusTypeDef songcontainer(const uint8_t *base, uint32_t bytes, songinfo_t *song)
+{
+    uint32_t entries, i;
+    uint8_t size;
+
+    if(bytes < SONG_HEADER || base[0] != 'S' || base[1] != 'G' || base[2] < 2 || base[2] > SONG_VERSION)
+    {
+        return HAL_ERROR;
+    }
+    size = base[3];
+    entries = 1u + base[4] + base[5];
+    if((size != 2 && size != 4) || base[4] > SONG_MAX_INSTRUMENTS || base[5] > SONG_MAX_TRACKS ||
+       !base[6] || base[6] > SONG_MAX_ORDERS || bytes - SONG_HEADER < entries * size)
+    {
+        return HAL_ERROR;
+    }
+    for(i = 0; i < entries; i++)
+    {
+        if(rdle(base + SONG_HEADER + i * size, size) >= bytes) return HAL_ERROR;
+    }
+
+    song->base = base;
+    song->bytes = bytes;
+    song->version = base[2];
+    song->instruments = base[4];
+    song->tracks = base[5];
+    song->orders = base[6];
+
+    return HAL_OK;
+}
+
+/* Song 'num' of the bank, or the built-in song when there is no bank */
+static HAL_StatusTypeDef songentry(uint8_t num, songinfo_t *song)
+{
+    const uint8_t *e;
+
+    if(!songbank)
+    {
+        if(num) return HAL_ERROR;
+        song->base = songdata;
+        song->bytes = sizeof(songdata);
+        song->version = 1;
+        song->instruments = SONG_MAX_INSTRUMENTS;
+        song->tracks = MAXTRACK;
+        song->orders = SONGLEN;
+        return HAL_OK;
+    }
+    if(num >= songcount) return HAL_ERROR;
+
+    if(songbank[2] == 1)
+    {
+        e = &songbank[SONGBANK_HEADER + num * SONGBANK_ENTRY_V1];
+        song->base = songbank + rdle(e, 2);
+        song->bytes = rdle(e + 2, 2);
+        song->version = 1;
+        song->instruments = SONG_MAX_INSTRUMENTS;
+        song->tracks = e[5];
+        song->orders = e[4];
+        return HAL_OK;
+    }
+
+    /* Checked by Chiptune_SetSongBank(), this only fills in the counts */
+    e = &songbank[SONGBANK_HEADER + num * SONGBANK_ENTRY];
+
+    return songcontainer(songbank + rdle(e, 4), rdle(e + 4, 4), song);
+}
+
+/* Switch the sequencer to another song, from its first order position */
+static void loadsong(const songinfo_t *song, uint8_t num)
+{
+    cursong = *song;
+    songnum = num;
+    replay = NULL;
+    seekready = 0;
+    looporder = SONG_NO_LOOP;
+    initresources();
+    resetsequencer();
+}
+
+/* Song start: sequencer and the oscillator registers it drives */
+static void resetsequencer(void)
 {
-    /* Initialize variables */
     trackwait = 0;
     trackpos = 0;
     playsong = 1;
     songpos = 0;
-    audioTicks = 0;
-
-    /* Initialize oscillators */
-    for(int i = 0; i < 4; i++)
+    rowspeed = TICKS_PER_ROW << 4;
+    light[0] = light[1] = 0;
+    memset(channel, 0, sizeof(channel));
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
     {
         osc[i].volume = 0;
         osc[i].freq = 0;
-        osc[i].phase = 0;
         osc[i].duty = 0x8000;
         osc[i].waveform = WF_TRI;
-        channel[i].inum = 0;
+        osc[i].pan = PAN_CENTER;
+        osc[i].gain = 0;
+        osc[i].table = &wavetables[0];
+        osc[i].sample = NULL;
+        osc[i].trigger++;
+        osc[i].sstep = 0;
+        osc[i].cutoff = 0xff;
+        osc[i].filter = 0;
     }
+    initup(&songup, resources[0]);
+}
 
-    /* Initialize resources */
-    initresources();
+static void savepoint(seekpoint_t *sp)
+{
+    sp->songup = songup;
+    sp->trackwait = trackwait;
+    sp->rowspeed = rowspeed;
+    memcpy(sp->channel, channel, sizeof(channel));
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        sp->osc[i].freq = osc[i].freq;
+        sp->osc[i].duty = osc[i].duty;
+        sp->osc[i].waveform = osc[i].waveform;
+        sp->osc[i].volume = osc[i].volume;
+        sp->osc[i].pan = osc[i].pan;
+        sp->osc[i].table = osc[i].table;
+        sp->osc[i].sample = osc[i].sample;
+        sp->osc[i].cutoff = osc[i].cutoff;
+        sp->osc[i].filter = osc[i].filter;
+    }
+}
 
-    /* Clear audio buffer */
-    for(int i = 0; i < AUDIO_BUFFER_SIZE; i++)
+/*
+ * Restores a seek point. Samples sounding at that point restart from
+ * their first frame: how far they had played depends on the mixer, which
+ * the index does not run.
+ */
+static void loadpoint(const seekpoint_t *sp)
+{
+    songup = sp->songup;
+    trackwait = sp->trackwait;
+    rowspeed = sp->rowspeed;
+    memcpy(channel, sp->channel, sizeof(channel));
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
     {
-        audioBuffer[i] = 0x8000;
+        osc[i].freq = sp->osc[i].freq;
+        osc[i].duty = sp->osc[i].duty;
+        osc[i].waveform = sp->osc[i].waveform;
+        osc[i].volume = sp->osc[i].volume;
+        osc[i].pan = sp->osc[i].pan;
+        osc[i].gain = mixgain(i, &osc[i], livevelocity[i]);
+        osc[i].table = sp->osc[i].table;
+        osc[i].sample = sp->osc[i].sample;
+        osc[i].cutoff = sp->osc[i].cutoff;
+        osc[i].filter = sp->osc[i].filter;
+        svfcoef(&osc[i]);
+        osc[i].trigger++;
+        if(osc[i].waveform == WF_SAMPLE && osc[i].sample)
+        {
+            osc[i].sstep = ((uint32_t)osc[i].freq << SAMPLE_FRAC_BITS) / osc[i].sample->basefreq;
+        }
     }
 }
 
-void Chiptune_Process(void)
+static void adpcmfill(adpcmring_t *r, const sample_t *s, uint32_t block)
+{
+    uint8_t slot = block & 1;
+    uint32_t start = Profile_Now();
+
+    ADPCM_DecodeBlock((const uint8_t *)s->data + block * ADPCM_BLOCK_BYTES, r->frames[slot]);
+    r->src[slot] = s;
+    r->block[slot] = block;
+    Profile_Update(&stats.adpcm, start);
+}
+
+/*
+ * Frame pos of an ADPCM sample. Blocks alternate between the two ring
+ * slots: entering a block decodes the one after it, so in steady state
+ * the mixer never waits and pays for one block per ADPCM_BLOCK_FRAMES
+ * frames. Only a trigger or loop jump decodes the current block on the
+ * spot.
+ */
+static inline int16_t adpcmframe(uint8_t ch, const sample_t *s, uint32_t pos, uint32_t end)
 {
-    static uint32_t lastUpdate = 0;
-    uint32_t now = HAL_GetTick();
+    adpcmring_t *r = &adpcmring[ch];
+    uint32_t block = pos / ADPCM_BLOCK_FRAMES;
+    uint8_t slot = block & 1;
 
-    /* Call playroutine at 50Hz (every 20ms) */
-    if (now - lastUpdate >= 20)
+    if(r->src[slot] != s || r->block[slot] != block)
     {
-        lastUpdate = now;
-        playroutine();
+        adpcmfill(r, s, block);
     }
+    if((block + 1) * ADPCM_BLOCK_FRAMES < end &&
+       (r->src[slot ^ 1] != s || r->block[slot ^ 1] != block + 1))
+    {
+        adpcmfill(r, s, block + 1);
+    }
+
+    return r->frames[slot][pos % ADPCM_BLOCK_FRAMES];
 }
 
-void Chiptune_AudioCallback(void)
+/*
+ * Current frame of a WF_SAMPLE voice, read straight from flash and scaled
+ * to 14 bits so it matches the fixed waveforms (-32..31) times 256. The
+ * position advances with the phases, on the last sub-sample.
+ */
+static inline int16_t samplevalue(uint8_t ch, const oscillator_t *o, uint8_t sub)
 {
-    uint8_t i;
-    int16_t acc;
-    uint8_t newbit;
+    voice_t *vc = &voice[ch];
+    const sample_t *s;
+    uint32_t end, pos;
+    int16_t v;
 
-    /* Toggle debug pin */
-    HAL_GPIO_TogglePin(GPIOD, GPIO_PIN_1);
+    if(vc->trigger != o->trigger)
+    {
+        vc->trigger = o->trigger;
+        vc->sample = o->sample;
+        vc->spos = 0;
+    }
+    s = vc->sample;
+    if(!s) return 0;
+
+    end = s->looplen ? s->loopstart + s->looplen : s->length;
+    pos = (vc->spos + (o->sstep * sub) / CHIPTUNE_OVERSAMPLE) >> SAMPLE_FRAC_BITS;
+    if(pos >= end) pos = end - 1;
+
+    if(s->format == SAMPLE_PCM16) v = ((const int16_t *)s->data)[pos] >> 2;
+    else if(s->format == SAMPLE_ADPCM) v = adpcmframe(ch, s, pos, end) >> 2;
+    else v = ((const int8_t *)s->data)[pos] << 6;
+
+    if(sub == CHIPTUNE_OVERSAMPLE - 1)
+    {
+        vc->spos += o->sstep;
+        if((vc->spos >> SAMPLE_FRAC_BITS) >= end)
+        {
+            if(s->looplen) vc->spos -= s->looplen << SAMPLE_FRAC_BITS;
+            else vc->sample = NULL;
+        }
+    }
+
+    return v;
+}
 
-    /* Update noise generator */
-    newbit = 0;
-    if(noiseseed & 0x80000000L) newbit ^= 1;
-    if(noiseseed & 0x01000000L) newbit ^= 1;
-    if(noiseseed & 0x00000040L) newbit ^= 1;
-    if(noiseseed & 0x00000200L) newbit ^= 1;
-    noiseseed = (noiseseed << 1) | newbit;
+#if !defined(__ARM_FEATURE_DSP)
+/* __SSAT in C: x clamped to -max - 1..max */
+static inline int32_t svfsat(int32_t x, int32_t max)
+{
+    return x > max ? max : (x < -max - 1 ? -max - 1 : x);
+}
+#endif
+
+/*
+ * One sample of a voice through its filter, x and the result 14-bit like
+ * samplevalue(). A topology-preserving state-variable filter: trapezoidal
+ * integrators keep it stable at every cutoff and resonance, and v1, v2
+ * and the mode mix are each one dual 16-bit MAC of a packed pair. The
+ * bits v1 and v2 drop start the next sample's MACs, or at low cutoffs
+ * the integrators would stick short of zero. They run a bit below x,
+ * room for a resonant peak of 8x before they saturate; the result
+ * saturates to the voice's range, keeping the mixer headroom.
+ */
+static inline int32_t svfrun(const oscillator_t *o, voice_t *vc, int32_t x)
+{
+    int32_t ic1 = (int16_t)vc->svf;
+    int32_t ic2 = (int16_t)(vc->svf >> 16);
+    int32_t hp = (o->filter & FILTER_HP) ? x * 8192 : 0;
+    int32_t v1, v2, y;
+
+    x >>= 1;
+#if defined(__ARM_FEATURE_DSP)
+    {
+        uint32_t p = __PKHBT(vc->svf, __SSAT(x - ic2, 16), 16);
+        int32_t s1 = (int32_t)__SMLAD(p, o->svf[0], vc->svferr & 0x7fff);
+        int32_t s2 = (int32_t)__SMLAD(p, o->svf[1], vc->svferr >> 16);
+
+        vc->svferr = __PKHBT(s1 & 0x7fff, s2, 16) & 0x7fff7fff;
+        v1 = __SSAT(s1 >> 15, 16);
+        v2 = __SSAT(ic2 + (s2 >> 15), 16);
+        vc->svf = __PKHBT(__SSAT(2 * v1 - ic1, 16), __SSAT(2 * v2 - ic2, 16), 16);
+        y = (int32_t)__SMLAD(__PKHBT(v1, v2, 16), o->svf[2], hp + (1 << 13)) >> 14;
+    }
+
+    return __SSAT(y * 2, 14);
+#else
+    x = svfsat(x - ic2, 32767);
+    v1 = (int16_t)o->svf[0] * ic1 + (int16_t)(o->svf[0] >> 16) * x + (int32_t)(vc->svferr & 0x7fff);
+    v2 = (int16_t)o->svf[1] * ic1 + (int16_t)(o->svf[1] >> 16) * x + (int32_t)(vc->svferr >> 16);
+    vc->svferr = (v1 & 0x7fff) | ((uint32_t)(v2 & 0x7fff) << 16);
+    v1 = svfsat(v1 >> 15, 32767);
+    v2 = svfsat(ic2 + (v2 >> 15), 32767);
+    vc->svf = (uint16_t)svfsat(2 * v1 - ic1, 32767) | ((uint32_t)svfsat(2 * v2 - ic2, 32767) << 16);
+    y = ((int16_t)o->svf[2] * v1 + (int16_t)(o->svf[2] >> 16) * v2 + hp + (1 << 13)) >> 14;
+
+    return svfsat(y * 2, 8191);
+#endif
+}
+
+/* A 14-bit voice value at its gain: two multiplies, the packed lanes add
+ * up the same way as the int8 waveforms' single one */
+static inline mix_t finemix(int32_t v, uint32_t gain)
+{
+#if CHIPTUNE_STEREO
+    return (uint32_t)((v * (int32_t)(gain & 0xffff)) >> 8) +
+           ((uint32_t)((v * (int32_t)(gain >> 16)) >> 8) << 16);
+#else
+    return (v * (int32_t)gain) >> 8;
+#endif
+}
+
+/*
+ * The published registers changed hands: a channel an effect borrows
+ * sets the music's voice aside and starts the effect with no sample and
+ * an empty filter, one handed back gets it back, so a sample the music was
+ * playing carries on from where the effect cut in, through its own
+ * filter state, even after a 'k' in the effect. The ADPCM rings are
+ * keyed by sample and block and decode again on their own.
+ */
+static void swapvoices(uint8_t sfx)
+{
+    uint8_t changed = sfx ^ voicesfx;
+    uint8_t ch;
+
+    for(ch = 0; changed >> ch; ch++)
+    {
+        if(!(changed & (1 << ch))) continue;
+        if(sfx & (1 << ch))
+        {
+            musicvoice[ch] = voice[ch];
+            voice[ch].sample = NULL;
+            voice[ch].svf = voice[ch].svferr = 0;
+        }
+        else
+        {
+            voice[ch] = musicvoice[ch];
+        }
+    }
+    voicesfx = sfx;
+}
+
+/*
+ * Render one sample of all voices at sub-sample position sub (of
+ * CHIPTUNE_OVERSAMPLE) within the current output sample. Phases advance
+ * by a full freq on the last sub-sample, so pitch does not depend on the
+ * oversampling factor. Stereo lanes come back already separated. o is
+ * the published copy of the registers, read once per output sample.
+ */
+static inline mix_t mixvoices(const oscillator_t *o, uint8_t sub)
+{
+    uint8_t solo = livesolo;
+    uint8_t off = solo ? ~solo : mutemask;    /* voices that run silently */
+    uint8_t i;
+    mix_t acc = 0;
 
-    /* Generate audio sample */
-    acc = 0;
     for(i = 0; i < 4; i++)
     {
+        uint16_t phase = voice[i].phase;
         int8_t value;
 
-        switch(osc[i].waveform)
+#if CHIPTUNE_OVERSAMPLE > 1
+        phase += (o[i].freq * sub) / CHIPTUNE_OVERSAMPLE;
+#endif
+
+        switch(o[i].waveform)
         {
         case WF_TRI:
-            if(osc[i].phase < 0x8000)
+            if(phase < 0x8000)
             {
-                value = -32 + (osc[i].phase >> 9);
+                value = -32 + (phase >> 9);
             }
             else
             {
-                value = 31 - ((osc[i].phase - 0x8000) >> 9);
+                value = 31 - ((phase - 0x8000) >> 9);
             }
             break;
         case WF_SAW:
-            value = -32 + (osc[i].phase >> 10);
+            value = -32 + (phase >> 10);
+#if CHIPTUNE_OVERSAMPLE == 1
+            if(bandlimit) value += blepcorrect(&o[i], &voice[i], phase);
+#endif
             break;
         case WF_PUL:
-            value = (osc[i].phase > osc[i].duty) ? -32 : 31;
+            value = (phase > o[i].duty) ? -32 : 31;
+#if CHIPTUNE_OVERSAMPLE == 1
+            if(bandlimit) value += blepcorrect(&o[i], &voice[i], phase);
+#endif
             break;
         case WF_NOI:
             value = (noiseseed & 63) - 32;
             break;
+        case WF_TABLE:
+            value = o[i].table->data[phase >> o[i].table->shift];
+            break;
+        case WF_SAMPLE:
+        {
+            /* Finer than the int8 waveforms: mixed by finemix(), then
+             * on to the next voice */
+            int32_t v = samplevalue(i, o, sub);
+
+            if(o[i].filter & FILTER_MODES) v = svfrun(&o[i], &voice[i], v);
+            if(sub == CHIPTUNE_OVERSAMPLE - 1) voice[i].phase += o[i].freq;
+            if(off & (1 << i)) continue;
+            acc += finemix(v, o[i].gain);
+            continue;
+        }
         default:
             value = 0;
             break;
         }
-        osc[i].phase += osc[i].freq;
+        if(sub == CHIPTUNE_OVERSAMPLE - 1) voice[i].phase += o[i].freq;
+        if(o[i].filter & FILTER_MODES)
+        {
+            /* Filtered, a waveform comes out as fine as a sample */
+            int32_t v = svfrun(&o[i], &voice[i], value * 256);
+
+            if(off & (1 << i)) continue;
+            acc += finemix(v, o[i].gain);
+            continue;
+        }
+        if(off & (1 << i)) continue;
+
+#if CHIPTUNE_STEREO
+        /* Both 16-bit lanes in one MLA: the sign of the left product
+         * borrows from the right lane, which is undone below. */
+        acc += (uint32_t)(int32_t)value * o[i].gain;
+#else
+        acc += value * (int32_t)o[i].gain;
+#endif
+    }
+
+#if CHIPTUNE_STEREO
+    /* Return the borrow to the right lane */
+    acc += (acc & 0x8000) << 1;
+#endif
+
+    return acc;
+}
+
+#if CHIPTUNE_OVERSAMPLE > 1
+static inline void decimpush(mix_t s)
+{
+    histl[histpos] = histl[histpos + DECIM_TAPS] = (int16_t)s;
+#if CHIPTUNE_STEREO
+    histr[histpos] = histr[histpos + DECIM_TAPS] = (int16_t)(s >> 16);
+#endif
+    if(++histpos == DECIM_TAPS) histpos = 0;
+}
+
+/*
+ * Decimating FIR evaluated at the output rate only: the polyphase form,
+ * with the CHIPTUNE_OVERSAMPLE branches interleaved in one tap array. The
+ * tap count is a multiple of the factor, so x is word-aligned here and
+ * each dual 16-bit MAC takes two samples and two taps.
+ */
+static inline int16_t firdecim(const int16_t *x)
+{
+    int32_t acc = 1 << 14;
+    uint8_t j;
+
+    for(j = 0; j < DECIM_TAPS; j += 2)
+    {
+        uint32_t xw, hw;
+
+        memcpy(&xw, &x[j], sizeof(xw));
+        memcpy(&hw, &decim_taps[j], sizeof(hw));
+#if defined(__ARM_FEATURE_DSP)
+        acc = __SMLAD(xw, hw, acc);
+#else
+        acc += (int16_t)xw * (int16_t)hw + (int16_t)(xw >> 16) * (int16_t)(hw >> 16);
+#endif
+    }
+    acc >>= 15;
+
+#if defined(__ARM_FEATURE_DSP)
+    return (int16_t)__SSAT(acc, 16);
+#else
+    return (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+#endif
+}
+
+static inline mix_t decimate(void)
+{
+#if CHIPTUNE_STEREO
+    return (uint16_t)firdecim(&histl[histpos]) | ((uint32_t)(uint16_t)firdecim(&histr[histpos]) << 16);
+#else
+    return firdecim(&histl[histpos]);
+#endif
+}
+#endif /* CHIPTUNE_OVERSAMPLE > 1 */
 
-        acc += value * osc[i].volume;
+/* Public functions ----------------------------------------------------------*/
+
+void Chiptune_Init(void)
+{
+    int8_t sine[64];
+
+#if CHIPTUNE_PRERENDERED
+    prerenderblock = 0;
+    bufferIndex = 0;
+    Profile_Init();
+    Chiptune_ResetStats();
+    for(int i = 0; i < AUDIO_BUFFER_SIZE; i++)
+    {
+        audioBuffer.sample[i] = 0x8000;
+    }
+    (void)sine;
+    return;
+#endif
+
+    /* Initialize variables */
+    audioTicks = 0;
+    tickperiod = tempoperiod(CHIPTUNE_TEMPO);
+    tickfrac = 0;
+    rampticks = 0;
+    nexttick = tickperiod >> 16;
+    bufferIndex = 0;
+    noiseseed = 1;
+    noisecount = 0;
+    postq.head = postq.tail = 0;
+    tickq.head = tickq.tail = 0;
+    mutemask = 0;
+    livesolo = 0;
+    livetranspose = 0;
+    sfxmask = 0;
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        sfx[i] = NULL;
+    }
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        livescale[i] = 255;
+        livebend[i] = 0;
+        livevelocity[i] = 255;
+    }
+#if CHIPTUNE_OVERSAMPLE > 1
+    memset(histl, 0, sizeof(histl));
+#if CHIPTUNE_STEREO
+    memset(histr, 0, sizeof(histr));
+#endif
+    histpos = 0;
+#endif
+
+    /* Initialize oscillators */
+    memset(voice, 0, sizeof(voice));
+    memset(osc, 0, sizeof(osc));
+    sfxbuf[0] = sfxbuf[1] = 0;
+    voicesfx = 0;
+
+    /* Initialize resources: the built-in song */
+    songbank = NULL;
+    songcount = 0;
+    pendingsong = SONG_NONE;
+    songentry(0, &nextsong);
+    loadsong(&nextsong, 0);
+
+    /* Wavetables: 0 is a sine, the rest silent until loaded */
+    for(int i = 0; i < WAVETABLE_COUNT; i++)
+    {
+        Chiptune_LoadWavetable(i, NULL, 32);
+    }
+    for(int i = 0; i < 64; i++)
+    {
+        sine[i] = sinetable[i] >> 2;
+    }
+    Chiptune_LoadWavetable(0, sine, 64);
+
+    /* CCMRAM is not initialised at startup: empty the decode rings */
+    for(int i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        adpcmring[i].src[0] = adpcmring[i].src[1] = NULL;
+    }
+    publish();
+
+    Profile_Init();
+    Chiptune_ResetStats();
+
+    /* Clear audio buffer */
+    for(int i = 0; i < AUDIO_BUFFER_SIZE; i++)
+    {
+        audioBuffer.sample[i] = 0x8000;
+    }
+}
+
+/*
+ * Main loop poll: runs the sequencer tick once the audio interrupt's
+ * sample count has reached its due time. The schedule is kept in samples,
+ * so no tempo drifts, but a tick is heard from the poll that runs it: up
+ * to a poll interval after its sample (8 samples with the firmware's 1 ms
+ * loop), and that lateness is not carried on to the next tick. Tools that
+ * poll every frame hear each tick at its sample. A late poll catches up a
+ * tick per call. Between ticks it applies the CHIPTUNE_EV_NOW events, so
+ * poll often for live input.
+ */
+void Chiptune_Process(void)
+{
+    const chiptune_event_t *e;
+
+#if CHIPTUNE_PRERENDERED
+    /* Nothing to sequence */
+    return;
+#endif
+
+    if((int32_t)(audioTicks - nexttick) >= 0)
+    {
+        Chiptune_Tick();
+        scheduletick();
+    }
+    else if((e = evpeek(&tickq)) != NULL && (e->type & CHIPTUNE_EV_NOW))
+    {
+        runlive();
+    }
+}
+
+/*
+ * One sequencer tick, now: Chiptune_Process() calls it on schedule, the
+ * host tools that run without the mixer call it directly.
+ */
+void Chiptune_Tick(void)
+{
+    uint32_t start = Profile_Now();
+
+#if CHIPTUNE_PRERENDERED
+    return;
+#endif
+
+    runevents();
+    if(pendingsong != SONG_NONE)
+    {
+        /* Switch on the tick boundary: the mixer keeps running and
+         * the new song's first row plays in this tick */
+        uint32_t switchstart = Profile_Now();
+
+        loadsong(&nextsong, pendingsong);
+        pendingsong = SONG_NONE;
+        Profile_Update(&stats.song, switchstart);
     }
+    if(replay) replaytick();
+    else playroutine();
+    if(sfxmask) sfxtick();
+    publish();
+    Profile_Update(&stats.tick, start);
+}
+
+void Chiptune_AudioCallback(void)
+{
+    mix_t acc;
+#if CHIPTUNE_OVERSAMPLE > 1
+    uint8_t sub;
+#endif
+    uint32_t start = Profile_Now();
+    const oscillator_t *o;
+    uint8_t f;
+
+    /* Toggle debug pin */
+    HAL_GPIO_TogglePin(GPIOD, GPIO_PIN_1);
 
+    /* Update noise generator: one precomputed bit per sample */
+    if(!noisecount)
+    {
+        noisebits = noiseblock(noiseseed);
+        noisecount = 32;
+    }
+    noiseseed = (noiseseed << 1) | (noisebits >> 31);
+    noisebits <<= 1;
+    noisecount--;
+
+    if(postq.tail != postq.head) takeevents();
+
+    /* Generate audio sample from the registers published last */
+    f = front;
+    o = oscbuf[f];
+    if(sfxbuf[f] != voicesfx) swapvoices(sfxbuf[f]);
+#if CHIPTUNE_OVERSAMPLE > 1
+    for(sub = 0; sub < CHIPTUNE_OVERSAMPLE; sub++)
+    {
+        decimpush(mixvoices(o, sub));
+    }
+    acc = decimate();
+#else
+    acc = mixvoices(o, 0);
+#endif
+
+#if CHIPTUNE_STEREO
+    /* Convert both lanes to unsigned 16-bit and store the L/R frame with
+     * one word write */
+    acc ^= 0x80008000;
+    lastsample16 = (uint16_t)acc;
+    audioBuffer.frame[bufferIndex >> 1] = acc;
+#else
     /* Convert to unsigned 16-bit */
     lastsample16 = (uint16_t)(acc + 32768);
 
     /* Store in buffer */
-    audioBuffer[bufferIndex] = lastsample16;
-    audioBuffer[bufferIndex + 1] = lastsample16; /* Stereo */
+    audioBuffer.sample[bufferIndex] = lastsample16;
+    audioBuffer.sample[bufferIndex + 1] = lastsample16; /* Stereo */
+#endif
     bufferIndex = (bufferIndex + 2) % AUDIO_BUFFER_SIZE;
 
     audioTicks++;
+    Profile_Update(&stats.mix, start);
 }
 
 void Chiptune_FillBuffer(uint8_t half)
 {
+#if CHIPTUNE_PRERENDERED
+    /* Refill the half the DMA just finished with the next block: one
+     * ADPCM block per channel is exactly one half-buffer of frames */
+    uint32_t *dst = &audioBuffer.frame[half == FIRST_HALF ? 0 : AUDIO_BUFFER_SIZE / 4];
+    int16_t left[ADPCM_BLOCK_FRAMES];
+    int16_t right[ADPCM_BLOCK_FRAMES];
+    uint32_t start = Profile_Now();
+    uint16_t i;
+
+    if(prerenderblock >= PRERENDER_BLOCKS)
+    {
+        for(i = 0; i < ADPCM_BLOCK_FRAMES; i++) dst[i] = 0x80008000;
+        return;
+    }
+
+    ADPCM_DecodeBlock(&prerender_data[(prerenderblock * PRERENDER_CHANNELS) * ADPCM_BLOCK_BYTES], left);
+#if PRERENDER_CHANNELS == 2
+    ADPCM_DecodeBlock(&prerender_data[(prerenderblock * 2 + 1) * ADPCM_BLOCK_BYTES], right);
+#else
+    memcpy(right, left, sizeof(right));
+#endif
+    prerenderblock++;
+
+    for(i = 0; i < ADPCM_BLOCK_FRAMES; i++)
+    {
+        dst[i] = ((uint16_t)left[i] | ((uint32_t)(uint16_t)right[i] << 16)) ^ 0x80008000;
+    }
+    lastsample16 = (uint16_t)dst[ADPCM_BLOCK_FRAMES - 1];
+    Profile_Update(&stats.adpcm, start);
+#else
     /* DMA buffer management - if needed */
+    (void)half;
+#endif
 }
 
 uint16_t* getAudioBuffer(void)
 {
-    return audioBuffer;
+    return audioBuffer.sample;
+}
+
+/* Frame of getAudioBuffer() the audio interrupt writes next */
+uint16_t Chiptune_GetWriteFrame(void)
+{
+    return bufferIndex >> 1;
+}
+
+uint8_t Chiptune_IsPlaying(void)
+{
+#if CHIPTUNE_PRERENDERED
+    return prerenderblock < PRERENDER_BLOCKS;
+#else
+    if(replay) return replayticks < replay->songticks;
+    return playsong;
+#endif
+}
+
+/*
+ * Publish osc[] to the mixer now, for code that sets the registers itself
+ * instead of through the sequencer (Tools/aliasing); ticks do it anyway.
+ */
+void Chiptune_UpdateVoices(void)
+{
+    publish();
+}
+
+void Chiptune_SetPan(uint8_t ch, uint8_t pan)
+{
+    if(ch < CHIPTUNE_CHANNELS)
+    {
+        /* Packed gain is refreshed by the next playroutine tick */
+        osc[ch].pan = pan;
+    }
+}
+
+/*
+ * Live mix controls. Each is a single byte store, so any context may call
+ * them without blocking, and the song data is left alone. Mute and solo
+ * apply from the mixer's next sample, to the music and to effects alike;
+ * the mute mask is the one CHIPTUNE_EV_MUTE sets, whichever came last
+ * holds. The volume scale and transpose apply at the sequencer's next
+ * tick. Muted channels keep playing silently, and a non-zero solo mask
+ * overrides the mute mask.
+ */
+void Chiptune_SetMute(uint8_t mask)
+{
+    mutemask = mask;
+}
+
+void Chiptune_SetSolo(uint8_t mask)
+{
+    livesolo = mask;
+}
+
+/* Channel volume scale: 255 plays the song's volume, 0 silences */
+void Chiptune_SetChannelVolume(uint8_t ch, uint8_t scale)
+{
+    if(ch < CHIPTUNE_CHANNELS) livescale[ch] = scale;
+}
+
+/* Semitones added to every note the sequencer plays (not to a replayed dump) */
+void Chiptune_SetTranspose(int8_t semitones)
+{
+    livetranspose = semitones;
+}
+
+void Chiptune_SetBandLimited(uint8_t enable)
+{
+    bandlimit = enable;
+}
+
+/*
+ * Copy a wavetable into CCMRAM. len must be 32, 64 or 256; samples are
+ * clamped to -32..31 so WF_TABLE voices keep the mixer headroom of the
+ * fixed waveforms. NULL samples clear the table.
+ */
+HAL_StatusTypeDef Chiptune_LoadWavetable(uint8_t num, const int8_t *samples, uint16_t len)
+{
+    wavetable_t *wt;
+    uint16_t i;
+
+    if(num >= WAVETABLE_COUNT) return HAL_ERROR;
+
+    wt = &wavetables[num];
+    switch(len)
+    {
+    case 32:  wt->shift = 11; break;
+    case 64:  wt->shift = 10; break;
+    case 256: wt->shift = 8;  break;
+    default:  return HAL_ERROR;
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        int8_t s = samples ? samples[i] : 0;
+
+        if(s < -32) s = -32;
+        if(s > 31) s = 31;
+        wt->data[i] = s;
+    }
+
+    return HAL_OK;
+}
+
+/*
+ * Samples for command 'k', normally a const array in flash. The bank is
+ * referenced, not copied. A bank holding a sample the mixer cannot play
+ * (no frames, a basefreq of 0, a loop past the end or more frames than
+ * the 20.12 position holds) is refused and the current bank kept.
+ */
+HAL_StatusTypeDef Chiptune_SetSampleBank(const sample_t *bank, uint8_t count)
+{
+    uint8_t i;
+
+    for(i = 0; bank && i < count; i++)
+    {
+        const sample_t *s = &bank[i];
+
+        if(!s->length || !s->basefreq) return HAL_ERROR;
+        if(s->length > (UINT32_MAX >> SAMPLE_FRAC_BITS)) return HAL_ERROR;
+        if(s->looplen && (s->loopstart >= s->length || s->looplen > s->length - s->loopstart))
+        {
+            return HAL_ERROR;
+        }
+    }
+
+    samplebank = bank;
+    samplecount = bank ? count : 0;
+
+    return HAL_OK;
+}
+
+/*
+ * Sound effects for CHIPTUNE_EV_SFX, normally a const array in flash. The
+ * bank is referenced, not copied; effects already playing carry on.
+ */
+void Chiptune_SetSfxBank(const chiptune_sfx_t *bank, uint8_t count)
+{
+    sfxbank = bank;
+    sfxcount = bank ? count : 0;
+}
+
+/* Channels borrowed by sound effects, a bit per channel */
+uint8_t Chiptune_GetSfxChannels(void)
+{
+    return sfxmask;
+}
+
+/*
+ * Play a register dump from the next tick on instead of the song data,
+ * NULL returns control to the sequencer. Call after Chiptune_Init() so
+ * the oscillators start from the state the dump was recorded from. The
+ * dump is referenced, not copied.
+ */
+void Chiptune_PlayDump(const regdump_t *dump)
+{
+    replaypos = 0;
+    replayticks = 0;
+    replayidle = 0;
+    replay = dump;
+}
+
+/*
+ * Register a song bank (format at SONGBANK_VERSION, version 1 banks are
+ * still accepted), normally a const array in flash; it is referenced, not
+ * copied. The current song keeps playing until Chiptune_SelectSong(). NULL
+ * leaves only the built-in song.
+ */
+HAL_StatusTypeDef Chiptune_SetSongBank(const uint8_t *bank, uint32_t len)
+{
+    songinfo_t song;
+    uint32_t entry;
+    uint8_t i, size;
+
+    if(!bank)
+    {
+        songbank = NULL;
+        songcount = 0;
+        return HAL_OK;
+    }
+    if(len < SONGBANK_HEADER || bank[0] != 'S' || bank[1] != 'B' ||
+       (bank[2] != 1 && bank[2] != SONGBANK_VERSION) || !bank[3] || bank[3] >= SONG_EXTERNAL)
+    {
+        return HAL_ERROR;
+    }
+    entry = bank[2] == 1 ? SONGBANK_ENTRY_V1 : SONGBANK_ENTRY;
+    size = bank[2] == 1 ? 2 : 4;
+    if(len < SONGBANK_HEADER + bank[3] * entry) return HAL_ERROR;
+    for(i = 0; i < bank[3]; i++)
+    {
+        const uint8_t *e = &bank[SONGBANK_HEADER + i * entry];
+        uint32_t offset = rdle(e, size);
+        uint32_t bytes = rdle(e + size, size);
+
+        if(offset > len || bytes > len - offset) return HAL_ERROR;
+        if(bank[2] == 1)
+        {
+            /* Resource table: 13 bits per instrument and track */
+            if(!e[4] || e[4] > SONG_MAX_ORDERS || e[5] > SONG_MAX_TRACKS ||
+               bytes < ((16u + e[5]) * 13 + 7) / 8)
+            {
+                return HAL_ERROR;
+            }
+        }
+        else if(songcontainer(bank + offset, bytes, &song) != HAL_OK)
+        {
+            return HAL_ERROR;
+        }
+    }
+
+    /* A switch still pending refers to the old bank */
+    pendingsong = SONG_NONE;
+    songbank = bank;
+    songcount = bank[3];
+
+    return HAL_OK;
+}
+
+/*
+ * Switch to song 'num' of the bank at the next sequencer tick, from its
+ * start. Audio keeps running; the latency is at most one tick plus the
+ * switch itself, counted in Chiptune_GetStats() song.
+ */
+HAL_StatusTypeDef Chiptune_SelectSong(uint8_t num)
+{
+    if(songentry(num, &nextsong) != HAL_OK) return HAL_ERROR;
+
+    pendingsong = num;
+
+    return HAL_OK;
+}
+
+/*
+ * Switch to a song container outside the bank at the next sequencer tick,
+ * like Chiptune_SelectSong(). It is checked here and referenced, not
+ * copied, so it must stay in place while it plays; Chiptune_GetSong()
+ * then returns SONG_EXTERNAL.
+ */
+HAL_StatusTypeDef Chiptune_PlaySong(const uint8_t *song, uint32_t len)
+{
+    if(!song || songcontainer(song, len, &nextsong) != HAL_OK) return HAL_ERROR;
+
+    pendingsong = SONG_EXTERNAL;
+
+    return HAL_OK;
+}
+
+/*
+ * Queue a control event for its sample: a mute applies there, the others
+ * only at the first tick run after it (see CHIPTUNE_EVENTS). Events are taken in
+ * the order posted, so post them in time order, and from one context
+ * only: the main loop or one interrupt. HAL_BUSY when the queue is full.
+ */
+HAL_StatusTypeDef Chiptune_PostEvent(const chiptune_event_t *event)
+{
+    uint8_t type = event ? event->type & ~CHIPTUNE_EV_NOW : CHIPTUNE_EV_COUNT;
+    uint8_t perchannel = type == CHIPTUNE_EV_NOTE_ON || type == CHIPTUNE_EV_NOTE_OFF ||
+                         type == CHIPTUNE_EV_VOLUME || type == CHIPTUNE_EV_BEND || type == CHIPTUNE_EV_COMMAND ||
+                         type == CHIPTUNE_EV_VELOCITY;
+
+    if(type >= CHIPTUNE_EV_COUNT) return HAL_ERROR;
+    if(perchannel && event->ch >= CHIPTUNE_CHANNELS) return HAL_ERROR;
+    if((event->type & CHIPTUNE_EV_NOW) && !perchannel) return HAL_ERROR;
+    if(type == CHIPTUNE_EV_NOTE_ON && (!event->arg || event->arg > SONG_MAX_INSTRUMENTS)) return HAL_ERROR;
+    if(type == CHIPTUNE_EV_TEMPO && !event->value) return HAL_ERROR;
+    if(type == CHIPTUNE_EV_SPEED && event->value < 0x10) return HAL_ERROR;
+
+    return evpush(&postq, event) ? HAL_OK : HAL_BUSY;
+}
+
+/* Samples rendered since Chiptune_Init(), the time base of the events */
+uint32_t Chiptune_GetTime(void)
+{
+    return audioTicks;
+}
+
+uint8_t Chiptune_GetSong(void)
+{
+    return songnum;
+}
+
+/*
+ * Run the sequencer silently through the whole song and keep its state at
+ * every order position, for Chiptune_Seek() and Chiptune_SetLoop(). Costs
+ * one playroutine per tick of the song, so call it after Chiptune_Init()
+ * and before the audio timer is started; playback then starts from the
+ * beginning as usual. A song switch still pending is made first.
+ */
+HAL_StatusTypeDef Chiptune_BuildSeekIndex(void)
+{
+    if(pendingsong != SONG_NONE)
+    {
+        loadsong(&nextsong, pendingsong);
+        pendingsong = SONG_NONE;
+    }
+    seekready = 0;
+    resetsequencer();
+    while(playsong)
+    {
+        if(!trackpos && trackwait < 16 && songpos < cursong.orders)
+        {
+            savepoint(&seekindex[songpos]);
+        }
+        playroutine();
+    }
+
+    resetsequencer();
+    seekready = 1;
+
+    return HAL_OK;
+}
+
+/*
+ * Continue playback from row 'row' of order position 'order', with
+ * instruments, slides and vibrato in the state sequential playback would
+ * have left them. Restores the indexed order state and replays at most
+ * TRACKLEN rows of ticks, so the cost does not depend on the position.
+ */
+HAL_StatusTypeDef Chiptune_Seek(uint8_t order, uint8_t row)
+{
+    if(!seekready || replay || order >= cursong.orders || row >= TRACKLEN) return HAL_ERROR;
+
+    loadpoint(&seekindex[order]);
+    songpos = order;
+    trackpos = 0;
+    playsong = 1;
+    while(playsong && (trackpos != row || trackwait >= 16))
+    {
+        playroutine();
+    }
+    publish();
+
+    return HAL_OK;
+}
+
+/*
+ * Jump back to order position 'order' instead of stopping at the end of
+ * the song; SONG_NO_LOOP stops. Needs the seek index.
+ */
+HAL_StatusTypeDef Chiptune_SetLoop(uint8_t order)
+{
+    if(order != SONG_NO_LOOP && (!seekready || order >= cursong.orders)) return HAL_ERROR;
+
+    looporder = order;
+
+    return HAL_OK;
+}
+
+static void wr8(uint8_t **p, uint8_t v)
+{
+    *(*p)++ = v;
+}
+
+static void wr16(uint8_t **p, uint16_t v)
+{
+    wr8(p, v & 0xff);
+    wr8(p, v >> 8);
+}
+
+static void wr32(uint8_t **p, uint32_t v)
+{
+    wr16(p, v & 0xffff);
+    wr16(p, v >> 16);
+}
+
+static uint8_t rd8(const uint8_t **p)
+{
+    return *(*p)++;
+}
+
+static uint16_t rd16(const uint8_t **p)
+{
+    uint16_t v = rd8(p);
+
+    return v | (rd8(p) << 8);
+}
+
+static uint32_t rd32(const uint8_t **p)
+{
+    uint32_t v = rd16(p);
+
+    return v | ((uint32_t)rd16(p) << 16);
+}
+
+/* Unpacker byte offset in a blob, little endian, within the song data */
+static uint8_t songoffsetok(const uint8_t *p, uint32_t bytes)
+{
+    return rdle(p, 4) <= bytes;
+}
+
+/* Tick period in a blob, one CHIPTUNE_EV_TEMPO can set */
+static uint8_t periodok(const uint8_t *p)
+{
+    uint32_t period = rdle(p, 4);
+
+    return period >= tempoperiod(255) && period <= tempoperiod(1);
+}
+
+/*
+ * Serialise everything playback depends on - sequencer, channels,
+ * oscillators including phases, sample positions and filters, noise
+ * generator, decimator history, tick timing and the live mix controls
+ * (mute, solo, channel volume, transpose, bend and velocity) - so
+ * Chiptune_LoadState() continues with the same samples. Wavetables, the
+ * sample bank and a replayed dump are configuration: they are referenced
+ * by number or not at all and must be set up the same way before
+ * loading. Sound effects are not kept. Needs STATE_SIZE bytes, at most
+ * CHIPTUNE_STATE_MAX.
+ */
+HAL_StatusTypeDef Chiptune_SaveState(uint8_t *blob, uint32_t size, uint32_t *len)
+{
+    uint8_t *p = blob;
+    int i;
+
+    if(size < STATE_SIZE) return HAL_ERROR;
+
+    wr8(&p, 'C');
+    wr8(&p, 'S');
+    wr8(&p, CHIPTUNE_STATE_VERSION);
+    wr8(&p, STATE_CONFIG);
+    wr16(&p, STATE_SIZE - STATE_HEADER);
+
+    /* The mixer must not move on while its state is copied */
+    __disable_irq();
+
+    wr8(&p, trackwait);
+    wr8(&p, trackpos);
+    wr8(&p, playsong);
+    wr8(&p, songpos);
+    wr8(&p, looporder);
+    wr8(&p, bandlimit);
+    wr8(&p, light[0]);
+    wr8(&p, light[1]);
+    wr32(&p, songup.nextbyte);
+    wr8(&p, songup.buffer);
+    wr8(&p, songup.bits);
+    wr32(&p, noiseseed);
+    wr32(&p, noisebits);
+    wr8(&p, noisecount);
+    wr32(&p, audioTicks);
+    wr32(&p, nexttick);
+    wr8(&p, replay != NULL);
+    wr32(&p, replaypos);
+    wr32(&p, replayticks);
+    wr8(&p, replayidle);
+    wr8(&p, songnum);
+    wr16(&p, tickfrac);
+    wr32(&p, tickperiod);
+    wr32(&p, (uint32_t)tickstep);
+    wr32(&p, rampperiod);
+    wr8(&p, rampticks);
+    wr8(&p, rowspeed);
+    wr8(&p, mutemask);
+    wr8(&p, livesolo);
+    wr8(&p, (uint8_t)livetranspose);
+
+#if CHIPTUNE_OVERSAMPLE > 1
+    wr16(&p, histpos);
+    for(i = 0; i < DECIM_TAPS; i++) wr16(&p, histl[i]);
+#if CHIPTUNE_STEREO
+    for(i = 0; i < DECIM_TAPS; i++) wr16(&p, histr[i]);
+#endif
+#endif
+
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        const oscillator_t *o = &osc[i];
+        /* The music's voice, also under an effect */
+        const voice_t *v = (voicesfx & (1 << i)) ? &musicvoice[i] : &voice[i];
+        /* A sample triggered since the mixer last played this voice */
+        uint8_t restart = v->trigger != o->trigger;
+        const sample_t *s = restart ? o->sample : v->sample;
+
+        wr16(&p, o->freq);
+        wr16(&p, v->phase);
+        wr16(&p, o->duty);
+        wr8(&p, o->waveform);
+        wr8(&p, o->volume);
+        wr8(&p, o->pan);
+        wr16(&p, v->blepfreq);
+        wr32(&p, v->bleprcp);
+        wr8(&p, o->table - wavetables);
+        wr8(&p, s ? s - samplebank : 0xff);
+        wr32(&p, restart ? 0 : v->spos);
+        wr32(&p, o->sstep);
+        wr8(&p, o->cutoff);
+        wr8(&p, o->filter);
+        wr32(&p, v->svf);
+        wr32(&p, v->svferr);
+    }
+
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        struct channel *c = &channel[i];
+
+        wr32(&p, c->trackup.nextbyte);
+        wr8(&p, c->trackup.buffer);
+        wr8(&p, c->trackup.bits);
+        wr8(&p, c->tnum);
+        wr8(&p, c->transp);
+        wr8(&p, c->tnote);
+        wr8(&p, c->lastinstr);
+        wr8(&p, c->inum);
+        wr16(&p, c->iptr);
+        wr8(&p, c->iwait);
+        wr8(&p, c->inote);
+        wr8(&p, c->bendd);
+        wr16(&p, c->bend);
+        wr8(&p, c->volumed);
+        wr16(&p, c->dutyd);
+        wr8(&p, c->vdepth);
+        wr8(&p, c->vrate);
+        wr8(&p, c->vpos);
+        wr16(&p, c->inertia);
+        wr16(&p, c->slur);
+        wr8(&p, livescale[i]);
+        wr8(&p, (uint8_t)livebend[i]);
+        wr8(&p, livevelocity[i]);
+    }
+
+    __enable_irq();
+
+    *len = p - blob;
+
+    return HAL_OK;
+}
+
+/*
+ * Resume from a Chiptune_SaveState() blob, switching to its song of the
+ * bank if another is playing; a Chiptune_PlaySong() song must be playing
+ * or about to. The blob is checked before anything is changed: HAL_ERROR
+ * leaves the engine as it was.
+ */
+HAL_StatusTypeDef Chiptune_LoadState(const uint8_t *blob, uint32_t len)
+{
+    const uint8_t *p = blob;
+    const uint8_t *q;
+    songinfo_t song;
+    uint8_t same;
+    int i;
+
+    if(len != STATE_SIZE || blob[0] != 'C' || blob[1] != 'S' ||
+       blob[2] != CHIPTUNE_STATE_VERSION || blob[3] != STATE_CONFIG ||
+       (blob[4] | (blob[5] << 8)) != STATE_SIZE - STATE_HEADER)
+    {
+        return HAL_ERROR;
+    }
+
+    /* Validate what becomes an index or a song offset */
+    q = blob + STATE_HEADER;
+    same = q[STATE_G_SONG] == songnum;
+    if(same) song = cursong;
+    else if(q[STATE_G_SONG] == SONG_EXTERNAL && pendingsong == SONG_EXTERNAL) song = nextsong;
+    else if(songentry(q[STATE_G_SONG], &song) != HAL_OK) return HAL_ERROR;
+    if(q[STATE_G_LOOP] != SONG_NO_LOOP && (!same || !seekready || q[STATE_G_LOOP] >= song.orders)) return HAL_ERROR;
+    if(!songoffsetok(&q[STATE_G_SONGUP], song.bytes)) return HAL_ERROR;
+    if(q[STATE_G_REPLAY] && (!same || !replay || rdle(&q[STATE_G_REPLAYPOS], 4) > replay->length)) return HAL_ERROR;
+    if(!periodok(&q[STATE_G_TICKPERIOD]) || (q[STATE_G_RAMPTICKS] && !periodok(&q[STATE_G_RAMPPERIOD]))) return HAL_ERROR;
+    if(q[STATE_G_ROWSPEED] < 0x10) return HAL_ERROR;
+    q += STATE_GLOBALS + STATE_DECIM;
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++, q += STATE_OSC)
+    {
+        if(q[STATE_O_TABLE] >= WAVETABLE_COUNT) return HAL_ERROR;
+        if(q[STATE_O_SAMPLE] != 0xff && q[STATE_O_SAMPLE] >= samplecount) return HAL_ERROR;
+    }
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++, q += STATE_CHANNEL)
+    {
+        if(!songoffsetok(&q[STATE_C_TRACKUP], song.bytes)) return HAL_ERROR;
+        if(q[STATE_C_TNUM] > song.tracks) return HAL_ERROR;
+        if(q[STATE_C_LASTINSTR] > SONG_MAX_INSTRUMENTS || q[STATE_C_INUM] > SONG_MAX_INSTRUMENTS) return HAL_ERROR;
+    }
+
+    /* A blob from another song switches to it */
+    if(!same)
+    {
+        pendingsong = SONG_NONE;
+        loadsong(&song, blob[STATE_HEADER + STATE_G_SONG]);
+    }
+
+    p += STATE_HEADER;
+    __disable_irq();
+
+    trackwait = rd8(&p);
+    trackpos = rd8(&p);
+    playsong = rd8(&p);
+    songpos = rd8(&p);
+    looporder = rd8(&p);
+    bandlimit = rd8(&p);
+    light[0] = rd8(&p);
+    light[1] = rd8(&p);
+    songup.nextbyte = rd32(&p);
+    songup.buffer = rd8(&p);
+    songup.bits = rd8(&p);
+    noiseseed = rd32(&p);
+    noisebits = rd32(&p);
+    noisecount = rd8(&p);
+    audioTicks = rd32(&p);
+    nexttick = rd32(&p);
+    if(!rd8(&p)) replay = NULL;
+    replaypos = rd32(&p);
+    replayticks = rd32(&p);
+    replayidle = rd8(&p);
+    (void)rd8(&p);
+    tickfrac = rd16(&p);
+    tickperiod = rd32(&p);
+    tickstep = (int32_t)rd32(&p);
+    rampperiod = rd32(&p);
+    rampticks = rd8(&p);
+    rowspeed = rd8(&p);
+    mutemask = rd8(&p);
+    livesolo = rd8(&p);
+    livetranspose = (int8_t)rd8(&p);
+
+#if CHIPTUNE_OVERSAMPLE > 1
+    histpos = rd16(&p) % DECIM_TAPS;
+    for(i = 0; i < DECIM_TAPS; i++) histl[i] = histl[i + DECIM_TAPS] = rd16(&p);
+#if CHIPTUNE_STEREO
+    for(i = 0; i < DECIM_TAPS; i++) histr[i] = histr[i + DECIM_TAPS] = rd16(&p);
+#endif
+#endif
+
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        oscillator_t *o = &osc[i];
+        voice_t *v = (voicesfx & (1 << i)) ? &musicvoice[i] : &voice[i];
+        uint8_t sample;
+
+        o->freq = rd16(&p);
+        v->phase = rd16(&p);
+        o->duty = rd16(&p);
+        o->waveform = rd8(&p);
+        o->volume = rd8(&p);
+        o->pan = rd8(&p);
+        v->blepfreq = rd16(&p);
+        v->bleprcp = rd32(&p);
+        o->table = &wavetables[rd8(&p)];
+        sample = rd8(&p);
+        o->sample = v->sample = sample == 0xff ? NULL : &samplebank[sample];
+        v->spos = rd32(&p);
+        v->trigger = o->trigger;
+        o->sstep = rd32(&p);
+        o->cutoff = rd8(&p);
+        o->filter = rd8(&p);
+        svfcoef(o);
+        v->svf = rd32(&p);
+        v->svferr = rd32(&p) & 0x7fff7fff;
+
+        /* Decoded ADPCM blocks are refilled on demand */
+        adpcmring[i].src[0] = adpcmring[i].src[1] = NULL;
+    }
+
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++)
+    {
+        struct channel *c = &channel[i];
+
+        c->trackup.nextbyte = rd32(&p);
+        c->trackup.buffer = rd8(&p);
+        c->trackup.bits = rd8(&p);
+        c->tnum = rd8(&p);
+        c->transp = rd8(&p);
+        c->tnote = rd8(&p);
+        c->lastinstr = rd8(&p);
+        c->inum = rd8(&p) & 15;
+        c->iptr = rd16(&p);
+        c->iwait = rd8(&p);
+        c->inote = clampnote(rd8(&p));
+        c->bendd = rd8(&p);
+        c->bend = rd16(&p);
+        c->volumed = rd8(&p);
+        c->dutyd = rd16(&p);
+        c->vdepth = rd8(&p);
+        c->vrate = rd8(&p);
+        c->vpos = rd8(&p);
+        c->inertia = rd16(&p);
+        c->slur = rd16(&p);
+        livescale[i] = rd8(&p);
+        livebend[i] = (int8_t)rd8(&p);
+        livevelocity[i] = rd8(&p);
+        /* Through the volume scale and velocity just read */
+        osc[i].gain = mixgain(i, &osc[i], livevelocity[i]);
+    }
+    publish();
+
+    __enable_irq();
+
+    return HAL_OK;
+}
+
+void Chiptune_GetStats(chiptune_stats_t *out)
+{
+    __disable_irq();
+    *out = *(chiptune_stats_t *)&stats;
+    __enable_irq();
+}
+
+void Chiptune_ResetStats(void)
+{
+    __disable_irq();
+    stats.mix.last = stats.mix.max = stats.mix.total = stats.mix.count = 0;
+    stats.tick.last = stats.tick.max = stats.tick.total = stats.tick.count = 0;
+    stats.adpcm.last = stats.adpcm.max = stats.adpcm.total = stats.adpcm.count = 0;
+    stats.song.last = stats.song.max = stats.song.total = stats.song.count = 0;
+    stats.overruns = 0;
+    stats.sfxlatency = stats.sfxdropped = 0;
+    stats.livelatency = 0;
+    __enable_irq();
 }
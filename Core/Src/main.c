@@ -24,6 +24,18 @@
 #include "chiptune.h"
 
 #include "codec.h"
+#if CHIPTUNE_REPLAY
+#include "regdump.h"
+#endif
+#if CHIPTUNE_SONGBANK
+#include "songbank.h"
+#endif
+#if CHIPTUNE_MIDI
+#include "midi.h"
+#endif
+#if CHIPTUNE_UPLOAD
+#include "upload.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -33,7 +45,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+#define UPLOAD_RX_SIZE 512  /* song upload receive ring, over 40 ms at UPLOAD_BAUD */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -50,7 +62,11 @@ DMA_HandleTypeDef hdma_spi3_tx;
 TIM_HandleTypeDef htim2;
 
 /* USER CODE BEGIN PV */
-
+#if CHIPTUNE_UPLOAD
+static uint8_t uploadrx[UPLOAD_RX_SIZE];
+static volatile uint16_t uploadrxhead;
+static volatile uint16_t uploadrxtail;
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -61,11 +77,22 @@ static void MX_I2C1_Init(void);
 static void MX_I2S3_Init(void);
 static void MX_TIM2_Init(void);
 /* USER CODE BEGIN PFP */
-
+static HAL_StatusTypeDef Audio_Start(void);
+#if CHIPTUNE_MIDI
+static void MIDI_UART_Init(void);
+#endif
+#if CHIPTUNE_UPLOAD
+static void UPLOAD_UART_Init(void);
+static uint16_t UPLOAD_UART_Read(uint8_t *buf, uint16_t max);
+static void UPLOAD_UART_Write(const uint8_t *buf, uint16_t len);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+#if CHIPTUNE_UPLOAD
+static const upload_transport_t upload_uart = { UPLOAD_UART_Read, UPLOAD_UART_Write };
+#endif
 
 
 /* USER CODE END 0 */
@@ -117,21 +144,43 @@ int main(void)
 
   /* Initialize chiptune engine */
   Chiptune_Init();
-
-
-  /* Start I2S transmission with DMA */
-  if (HAL_I2S_Transmit_DMA(&hi2s3, (uint16_t*)getAudioBuffer(), AUDIO_BUFFER_SIZE) != HAL_OK)
+#if CHIPTUNE_REPLAY
+  Chiptune_PlayDump(&regdump);
+#endif
+#if CHIPTUNE_SONGBANK
+  if (Chiptune_SetSongBank(songbank, sizeof(songbank)) != HAL_OK ||
+      Chiptune_SelectSong(0) != HAL_OK)
   {
 	  Error_Handler();
   }
+#endif
+#if CHIPTUNE_MIDI
+  Midi_Init();
+  MIDI_UART_Init();
+#endif
+#if CHIPTUNE_UPLOAD
+  /* Plays the song stored last and erases the spare slots, which stalls
+   * the flash: before the audio starts */
+  Upload_Init(&upload_uart);
+  UPLOAD_UART_Init();
+#endif
+
 
   HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(TIM2_IRQn);
+#if !CHIPTUNE_PRERENDERED
   /* Start timer for 8kHz interrupt */
   if (HAL_TIM_Base_Start_IT(&htim2) != HAL_OK)
   {
 	  Error_Handler();
   }
+#endif
+
+  /* Start I2S transmission with DMA, behind the timer's writes */
+  if (Audio_Start() != HAL_OK)
+  {
+	  Error_Handler();
+  }
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -141,8 +190,28 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+#if CHIPTUNE_MIDI
+    Midi_Process();
+#endif
+#if CHIPTUNE_UPLOAD
+    Upload_Process();
+#endif
     Chiptune_Process();
 
+#if CHIPTUNE_SONGBANK
+    /* User button: next song, switched on the next tick */
+    {
+      static GPIO_PinState button = GPIO_PIN_RESET;
+      GPIO_PinState now = HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin);
+
+      if (now == GPIO_PIN_SET && button == GPIO_PIN_RESET)
+      {
+        Chiptune_SelectSong((Chiptune_GetSong() + 1) % SONGBANK_SONGS);
+      }
+      button = now;
+    }
+#endif
+
     if (HAL_GetTick() % 1000 < 10)
 	{
 	  HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_SET);
@@ -159,7 +228,7 @@ int main(void)
 		  /* DMA error - restart */
 		  __HAL_DMA_CLEAR_FLAG(&hdma_spi3_tx, DMA_FLAG_TEIF1_5);
 		  HAL_I2S_DMAStop(&hi2s3);
-		  HAL_I2S_Transmit_DMA(&hi2s3, (uint16_t*)getAudioBuffer(), AUDIO_BUFFER_SIZE);
+		  Audio_Start();
 	  }
 	}
 
@@ -463,6 +532,136 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/*
+ * Starts the I2S DMA on the audio ring. The TIM2 interrupt mixes into the
+ * ring a frame at a time and the DMA sends it on the same crystal, so the
+ * distance between the two holds once set: the DMA starts at frame 0 when
+ * the interrupt is about to write frame AUDIO_WRITE_LEAD, and each frame
+ * goes out that many frames after it is mixed rather than up to a ring
+ * later. A flash erase that holds the interrupt off shifts it until the
+ * next start.
+ */
+static HAL_StatusTypeDef Audio_Start(void)
+{
+#if !CHIPTUNE_PRERENDERED
+  while (Chiptune_GetWriteFrame() != AUDIO_WRITE_LEAD)
+  {
+  }
+#endif
+  return HAL_I2S_Transmit_DMA(&hi2s3, (uint16_t*)getAudioBuffer(), AUDIO_BUFFER_SIZE);
+}
+
+#if CHIPTUNE_MIDI
+/*
+ * MIDI in: USART3 RX on PD9 at 31250 baud, received by DMA1 stream 1
+ * channel 4 into the midi.c ring, circular. The idle line and the DMA half
+ * and full transfers interrupt (stm32f4xx_it.c). The HAL UART driver is
+ * not part of the project, so the registers are set directly.
+ */
+static void MIDI_UART_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  __HAL_RCC_USART3_CLK_ENABLE();
+
+  GPIO_InitStruct.Pin = GPIO_PIN_9;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  GPIO_InitStruct.Alternate = GPIO_AF7_USART3;
+  HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
+
+  DMA1_Stream1->CR = 0;
+  while (DMA1_Stream1->CR & DMA_SxCR_EN)
+  {
+  }
+  DMA1->LIFCR = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1 |
+                DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1;
+  DMA1_Stream1->PAR = (uint32_t)&USART3->DR;
+  DMA1_Stream1->M0AR = (uint32_t)Midi_GetRxBuffer();
+  DMA1_Stream1->NDTR = MIDI_RX_SIZE;
+  DMA1_Stream1->CR = (4U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_CIRC |
+                     DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_EN;
+
+  USART3->BRR = (HAL_RCC_GetPCLK1Freq() + MIDI_BAUD / 2) / MIDI_BAUD;
+  USART3->CR3 = USART_CR3_DMAR;
+  USART3->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_IDLEIE;
+
+  /* Below the audio interrupt, which they only stamp the time of */
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+  HAL_NVIC_SetPriority(USART3_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(USART3_IRQn);
+}
+#endif
+
+#if CHIPTUNE_UPLOAD
+/*
+ * Song upload link: USART2 TX on PA2 and RX on PA3 at UPLOAD_BAUD. Its
+ * receive DMA request is on DMA1 stream 5, which the I2S has, so the
+ * receive interrupt (stm32f4xx_it.c) takes each byte into uploadrx; the
+ * replies, a few bytes each, are written out directly.
+ */
+static void UPLOAD_UART_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  __HAL_RCC_USART2_CLK_ENABLE();
+
+  GPIO_InitStruct.Pin = GPIO_PIN_2|GPIO_PIN_3;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  USART2->BRR = (HAL_RCC_GetPCLK1Freq() + UPLOAD_BAUD / 2) / UPLOAD_BAUD;
+  USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE;
+
+  /* Below the audio interrupt, which is shorter than a byte */
+  HAL_NVIC_SetPriority(USART2_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(USART2_IRQn);
+}
+
+/* From the USART2 receive interrupt; a byte with the ring full is lost
+ * and its frame sent again */
+void UPLOAD_UART_Receive(uint8_t byte)
+{
+  uint16_t next = (uploadrxhead + 1) % UPLOAD_RX_SIZE;
+
+  if (next != uploadrxtail)
+  {
+    uploadrx[uploadrxhead] = byte;
+    __DMB();
+    uploadrxhead = next;
+  }
+}
+
+static uint16_t UPLOAD_UART_Read(uint8_t *buf, uint16_t max)
+{
+  uint16_t head = uploadrxhead, n = 0;
+
+  __DMB();
+  while (uploadrxtail != head && n < max)
+  {
+    buf[n++] = uploadrx[uploadrxtail];
+    uploadrxtail = (uploadrxtail + 1) % UPLOAD_RX_SIZE;
+  }
+  return n;
+}
+
+static void UPLOAD_UART_Write(const uint8_t *buf, uint16_t len)
+{
+  while (len--)
+  {
+    while (!(USART2->SR & USART_SR_TXE))
+    {
+    }
+    USART2->DR = *buf++;
+  }
+}
+#endif
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     if (htim->Instance == TIM2)
@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * @file           : midi.c
+  * @brief          : MIDI input: UART receive ring and running-status parser
+  ******************************************************************************
+  */
+
+#include "chiptune.h"
+#include "midi.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define NO_NOTE                0xFF
+#define VIBRATO_RATE           5      /* '~' rate until CC 76 sets one */
+
+/* Private types -------------------------------------------------------------*/
+/* What a MIDI channel has set on its engine channel */
+typedef struct {
+    uint8_t instr;
+    uint8_t note;         /* MIDI note playing, NO_NOTE if none */
+    uint8_t vdepth;       /* CC 1, '~' depth */
+    uint8_t vrate;        /* CC 76, '~' rate */
+} midichannel_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Receive ring, written by the DMA; rxhead, rxcount and rxtime by the
+ * interrupts. rxcount counts every byte received and rxdone those parsed,
+ * so a lap of the ring between two polls shows as MIDI_RX_SIZE or more. */
+static CHIPTUNE_TLS uint8_t rxbuf[MIDI_RX_SIZE] __attribute__((aligned(4)));
+static CHIPTUNE_TLS volatile uint16_t rxhead;
+static CHIPTUNE_TLS volatile uint32_t rxcount;
+static CHIPTUNE_TLS volatile uint32_t rxtime;
+static CHIPTUNE_TLS uint16_t rxtail;
+static CHIPTUNE_TLS uint32_t rxdone;
+
+/* Parser: the status in force (0 = none, data is skipped) and its data */
+static CHIPTUNE_TLS uint8_t status;
+static CHIPTUNE_TLS uint8_t data[2];
+static CHIPTUNE_TLS uint8_t count;
+
+static CHIPTUNE_TLS midichannel_t chan[CHIPTUNE_CHANNELS];
+static CHIPTUNE_TLS midi_stats_t stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void post(uint8_t type, uint8_t ch, uint8_t value, uint8_t arg, uint32_t time);
+static void command(uint8_t ch, char cmd, uint8_t param, uint32_t time);
+static uint8_t scale7(uint8_t value);
+static void control(uint8_t ch, uint8_t num, uint8_t value, uint32_t time);
+static void message(uint32_t time);
+static void parse(uint8_t b, uint32_t time);
+
+/* Private functions ---------------------------------------------------------*/
+
+static void post(uint8_t type, uint8_t ch, uint8_t value, uint8_t arg, uint32_t time)
+{
+    chiptune_event_t e = { time, type | CHIPTUNE_EV_NOW, ch, value, arg };
+
+    if(Chiptune_PostEvent(&e) != HAL_OK) stats.dropped++;
+}
+
+/* Runs an instrument command, by its letter in CHIPTUNE_COMMANDS */
+static void command(uint8_t ch, char cmd, uint8_t param, uint32_t time)
+{
+    static const char commands[] = CHIPTUNE_COMMANDS;
+    uint8_t num;
+
+    for(num = 0; commands[num] != cmd; num++);
+    post(CHIPTUNE_EV_COMMAND, ch, num, param, time);
+}
+
+/* A 7-bit MIDI value as an engine scale, 127 to 255 */
+static uint8_t scale7(uint8_t value)
+{
+    return value << 1 | value >> 6;
+}
+
+static void control(uint8_t ch, uint8_t num, uint8_t value, uint32_t time)
+{
+    midichannel_t *m = &chan[ch];
+
+    switch(num)
+    {
+    case 1:
+    case 76:
+        if(num == 1) m->vdepth = value >> 3;
+        else m->vrate = value >> 3;
+        command(ch, '~', m->vdepth << 4 | m->vrate, time);
+        break;
+    case 7:
+        post(CHIPTUNE_EV_VOLUME, ch, scale7(value), 0, time);
+        break;
+    case 10:
+        command(ch, 'p', scale7(value), time);
+        break;
+    case 74:
+        /* 'd' wraps outside 0x20-0xe0 */
+        command(ch, 'd', 0x20 + value * 0xc0 / 127, time);
+        break;
+    case 120:
+    case 123:
+        if(m->note != NO_NOTE) post(CHIPTUNE_EV_NOTE_OFF, ch, 0, 0, time);
+        m->note = NO_NOTE;
+        break;
+    case 121:
+        m->vdepth = 0;
+        post(CHIPTUNE_EV_BEND, ch, 0, 0, time);
+        post(CHIPTUNE_EV_VOLUME, ch, 255, 0, time);
+        command(ch, '~', m->vrate, time);
+        break;
+    }
+}
+
+/* A complete channel message in status and data[] */
+static void message(uint32_t time)
+{
+    uint8_t ch = status & 15;
+    midichannel_t *m = &chan[ch];
+    int16_t bend;
+
+    stats.messages++;
+    if(ch >= CHIPTUNE_CHANNELS) return;
+
+    switch(status >> 4)
+    {
+    case 0x9:
+        if(data[1])
+        {
+            if(data[0] < MIDI_NOTE_OFFSET) break;
+            m->note = data[0];
+            post(CHIPTUNE_EV_VELOCITY, ch, scale7(data[1]), 0, time);
+            post(CHIPTUNE_EV_NOTE_ON, ch, data[0] - MIDI_NOTE_OFFSET, m->instr, time);
+            break;
+        }
+        /* Velocity 0 is a note off */
+        /* fall through */
+    case 0x8:
+        if(data[0] != m->note) break;
+        m->note = NO_NOTE;
+        post(CHIPTUNE_EV_NOTE_OFF, ch, 0, 0, time);
+        break;
+    case 0xB:
+        control(ch, data[0], data[1], time);
+        break;
+    case 0xC:
+        if(data[0] < SONG_MAX_INSTRUMENTS) m->instr = data[0] + 1;
+        break;
+    case 0xE:
+        /* 14 bits centred on 0x2000 to 64ths of a semitone */
+        bend = ((data[1] << 7 | data[0]) - 0x2000) >> 6;
+        if(bend > 127) bend = 127;
+        post(CHIPTUNE_EV_BEND, ch, (uint8_t)bend, 0, time);
+        break;
+    }
+}
+
+static void parse(uint8_t b, uint32_t time)
+{
+    /* Real-time bytes may come between any two others */
+    if(b >= 0xF8) return;
+
+    if(b & 0x80)
+    {
+        /* System messages end running status; their data is skipped */
+        status = b < 0xF0 ? b : 0;
+        count = 0;
+        return;
+    }
+    if(!status) return;
+
+    data[count++] = b;
+    /* Program change and channel pressure have one data byte */
+    if(count < ((status & 0xE0) == 0xC0 ? 1 : 2)) return;
+    count = 0;
+    message(time);
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void Midi_Init(void)
+{
+    uint8_t ch;
+
+    rxhead = rxtail = 0;
+    rxcount = rxdone = 0;
+    rxtime = 0;
+    status = count = 0;
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+    {
+        chan[ch].instr = 1;
+        chan[ch].note = NO_NOTE;
+        chan[ch].vdepth = 0;
+        chan[ch].vrate = VIBRATO_RATE;
+    }
+    stats.messages = stats.dropped = stats.overruns = 0;
+}
+
+/* The ring the UART's receive DMA writes, MIDI_RX_SIZE bytes, circular */
+uint8_t *Midi_GetRxBuffer(void)
+{
+    return rxbuf;
+}
+
+/*
+ * UART idle line and DMA half/full transfer interrupts: 'pos' is the ring
+ * offset the DMA writes next. The bytes before it are stamped now, which
+ * the idle line puts one character after the last of them.
+ */
+void Midi_RxInterrupt(uint16_t pos)
+{
+    pos %= MIDI_RX_SIZE;
+    rxtime = Chiptune_GetTime();
+    /* The DMA half and full interrupts come every half ring, so the bytes
+     * since the last interrupt are never a whole lap */
+    rxcount += (pos - rxhead + MIDI_RX_SIZE) % MIDI_RX_SIZE;
+    rxhead = pos;
+}
+
+/*
+ * Main loop poll, before Chiptune_Process(): parses the bytes received up
+ * to the last interrupt and posts their events. If MIDI_RX_SIZE bytes came
+ * since the last poll, the ring has been overwritten: they are dropped and
+ * counted in overruns. Call it from the context that posts any other
+ * events, Chiptune_PostEvent() takes one producer.
+ */
+void Midi_Process(void)
+{
+    uint32_t time, received;
+    uint16_t head;
+
+    /* Time, count and position of the same interrupt */
+    __disable_irq();
+    time = rxtime;
+    received = rxcount;
+    head = rxhead;
+    __enable_irq();
+    if(received - rxdone >= MIDI_RX_SIZE)
+    {
+        /* The DMA lapped the bytes not yet parsed: drop them all and pick
+         * up at the next status byte */
+        stats.overruns++;
+        rxtail = head;
+        status = count = 0;
+    }
+    rxdone = received;
+    while(rxtail != head)
+    {
+        parse(rxbuf[rxtail], time);
+        rxtail = (rxtail + 1) % MIDI_RX_SIZE;
+    }
+}
+
+void Midi_GetStats(midi_stats_t *s)
+{
+    *s = stats;
+}
@@ -22,6 +22,10 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "chiptune.h"
+#if CHIPTUNE_MIDI
+#include "midi.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -228,5 +232,49 @@ void TIM2_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+#if CHIPTUNE_MIDI
+/**
+  * @brief This function handles USART3 global interrupt: MIDI in idle line.
+  */
+void USART3_IRQHandler(void)
+{
+  if (USART3->SR & USART_SR_IDLE)
+  {
+    /* Reading SR then DR clears it */
+    (void)USART3->DR;
+    Midi_RxInterrupt(MIDI_RX_SIZE - DMA1_Stream1->NDTR);
+  }
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt: MIDI in ring
+  *        half and full.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  uint32_t flags = DMA1->LISR & (DMA_LISR_HTIF1 | DMA_LISR_TCIF1);
+
+  DMA1->LIFCR = flags;
+  if (flags)
+  {
+    Midi_RxInterrupt(MIDI_RX_SIZE - DMA1_Stream1->NDTR);
+  }
+}
+#endif
+
+#if CHIPTUNE_UPLOAD
+/**
+  * @brief This function handles USART2 global interrupt: song upload receive.
+  */
+void USART2_IRQHandler(void)
+{
+  /* Reading SR then DR clears RXNE and an overrun; the byte lost to one
+   * fails its frame's CRC */
+  if (USART2->SR & (USART_SR_RXNE | USART_SR_ORE))
+  {
+    UPLOAD_UART_Receive(USART2->DR);
+  }
+}
+#endif
 
 /* USER CODE END 1 */
@@ -0,0 +1,469 @@
+/**
+  ******************************************************************************
+  * @file           : upload.c
+  * @brief          : Song upload: framed transfers into spare flash slots
+  ******************************************************************************
+  */
+
+#include <string.h>
+
+#include "chiptune.h"
+#include "upload.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SLOT_MAGIC             0x47535055u   /* "UPSG", the slot header's first word */
+
+/* Slot header words */
+#define HDR_MAGIC              0
+#define HDR_LENGTH             4
+#define HDR_CRC                8
+#define HDR_GENERATION         12
+
+/* Private variables ---------------------------------------------------------*/
+static const upload_transport_t *stream;
+
+/* Parser: the frame so far, from its sync byte */
+static uint8_t frame[UPLOAD_FRAME_MAX];
+static uint16_t have;
+
+/* Slots that can be programmed, the song length and CRC-32 of an upload
+ * left part programmed in a slot (0 for none), and the newest header's
+ * generation */
+static uint8_t erased[UPLOAD_SLOTS];
+static uint32_t partlength[UPLOAD_SLOTS], partcrc[UPLOAD_SLOTS];
+static uint32_t generation;
+
+/* The upload: song length and CRC-32 from UPLOAD_BEGIN, bytes received and
+ * bytes programmed with the CRC-32 read back of them */
+static uint8_t receiving;
+static uint8_t ended;         /* the last upload switched, for a repeated UPLOAD_END */
+static uint8_t fault;         /* UPLOAD_ERR_FLASH or UPLOAD_ERR_SONG once the slot is spoilt */
+static uint8_t slot;
+static uint32_t lastframe;    /* HAL_GetTick() of the last frame taken */
+static uint32_t length, crc;
+static uint32_t received, written, sum;
+
+/* Double buffer: chunks received, 'queued' of them from 'head' waiting to
+ * be programmed, 'done' bytes of head's programmed */
+static uint8_t buf[2][UPLOAD_CHUNK] __attribute__((aligned(4)));
+static uint16_t buflen[2];
+static uint8_t head, queued;
+static uint16_t done;
+
+static upload_stats_t stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t rd16(const uint8_t *p);
+static uint32_t rd32(const uint8_t *p);
+static uint32_t slotaddr(uint8_t n);
+static uint8_t slotvalid(uint8_t n, uint32_t *gen);
+static uint8_t slotblank(uint8_t n);
+static HAL_StatusTypeDef erase(uint8_t n);
+static HAL_StatusTypeDef commit(void);
+static uint8_t program(void);
+static void abandon(void);
+static uint8_t begin(const uint8_t *p, uint16_t len);
+static uint8_t chunk(const uint8_t *p, uint16_t len);
+static uint8_t end(uint16_t len);
+static void reply(uint8_t type, uint8_t seq, uint8_t err);
+static void handle(uint8_t type, uint8_t seq, const uint8_t *p, uint16_t len);
+static void parse(uint8_t b);
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint32_t slotaddr(uint8_t n)
+{
+    return UPLOAD_SLOT_ADDR + n * UPLOAD_SLOT_SIZE;
+}
+
+/* A complete slot whose song matches its CRC-32 */
+static uint8_t slotvalid(uint8_t n, uint32_t *gen)
+{
+    const uint8_t *h = UPLOAD_FLASH(slotaddr(n));
+    uint32_t len = rd32(h + HDR_LENGTH);
+
+    if(rd32(h + HDR_MAGIC) != SLOT_MAGIC || !len || len > UPLOAD_SONG_MAX) return 0;
+    if(Upload_Crc32(h + UPLOAD_SLOT_HEADER, len, 0) != rd32(h + HDR_CRC)) return 0;
+    *gen = rd32(h + HDR_GENERATION);
+
+    return 1;
+}
+
+static uint8_t slotblank(uint8_t n)
+{
+    const uint8_t *p = UPLOAD_FLASH(slotaddr(n));
+    uint32_t i;
+
+    for(i = 0; i < UPLOAD_SLOT_SIZE; i += 4)
+    {
+        if(rd32(p + i) != 0xFFFFFFFFu) return 0;
+    }
+
+    return 1;
+}
+
+/* Stalls flash reads for the whole erase: not while the audio plays */
+static HAL_StatusTypeDef erase(uint8_t n)
+{
+    FLASH_EraseInitTypeDef e = {0};
+    uint32_t error;
+
+    e.TypeErase = FLASH_TYPEERASE_SECTORS;
+    e.Sector = UPLOAD_SLOT_SECTOR + n;
+    e.NbSectors = 1;
+    e.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    return HAL_FLASHEx_Erase(&e, &error);
+}
+
+/* Header of the programmed slot, the magic word last */
+static HAL_StatusTypeDef commit(void)
+{
+    uint32_t base = slotaddr(slot);
+
+    if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, base + HDR_LENGTH, length) != HAL_OK ||
+       HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, base + HDR_CRC, crc) != HAL_OK ||
+       HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, base + HDR_GENERATION, generation + 1) != HAL_OK ||
+       HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, base + HDR_MAGIC, SLOT_MAGIC) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    generation++;
+
+    return HAL_OK;
+}
+
+/* Programs up to UPLOAD_WORDS words of the queued chunks, checking and
+ * summing each as it reads back; UPLOAD_ERR_FLASH if one does not take */
+static uint8_t program(void)
+{
+    uint8_t words;
+
+    for(words = 0; queued && words < UPLOAD_WORDS; words++)
+    {
+        uint32_t addr = slotaddr(slot) + UPLOAD_SLOT_HEADER + written;
+        uint32_t w = rd32(buf[head] + done);
+        uint16_t n = buflen[head] - done < 4 ? buflen[head] - done : 4;
+
+        erased[slot] = 0;
+        /* A resumed upload finds its earlier words programmed already */
+        if((rd32(UPLOAD_FLASH(addr)) != w && HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, w) != HAL_OK) ||
+           rd32(UPLOAD_FLASH(addr)) != w)
+        {
+            return UPLOAD_ERR_FLASH;
+        }
+        sum = Upload_Crc32(UPLOAD_FLASH(addr), n, sum);
+        written += n;
+        done += 4;
+        if(done >= buflen[head])
+        {
+            head ^= 1;
+            queued--;
+            done = 0;
+        }
+    }
+
+    return 0;
+}
+
+/* Ends the upload in progress; a slot it part programmed is kept for the
+ * same song to resume in, unless spoilt */
+static void abandon(void)
+{
+    if(!receiving) return;
+    if(!erased[slot] && !fault)
+    {
+        partlength[slot] = length;
+        partcrc[slot] = crc;
+    }
+    HAL_FLASH_Lock();
+    receiving = 0;
+}
+
+static uint8_t begin(const uint8_t *p, uint16_t len)
+{
+    uint32_t size, check;
+    uint8_t n;
+
+    if(len != 8) return UPLOAD_ERR_SEQUENCE;
+    size = rd32(p);
+    check = rd32(p + 4);
+    /* Repeated after a lost reply */
+    if(receiving && !received && size == length && check == crc) return 0;
+
+    /* Any other starts over */
+    abandon();
+    ended = 0;
+    if(!size || size > UPLOAD_SONG_MAX) return UPLOAD_ERR_SIZE;
+    /* The same song again resumes in the slot it was left in; the sender
+     * starts from offset 0, and the words already there are skipped */
+    for(n = 0; n < UPLOAD_SLOTS && (partlength[n] != size || partcrc[n] != check); n++);
+    if(n < UPLOAD_SLOTS)
+    {
+        partlength[n] = 0;
+        stats.resumed++;
+    }
+    else
+    {
+        for(n = 0; n < UPLOAD_SLOTS && !erased[n]; n++);
+        if(n == UPLOAD_SLOTS) return UPLOAD_ERR_NOSLOT;
+    }
+
+    slot = n;
+    length = size;
+    crc = check;
+    received = written = sum = 0;
+    head = queued = 0;
+    done = 0;
+    fault = 0;
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    receiving = 1;
+
+    return 0;
+}
+
+static uint8_t chunk(const uint8_t *p, uint16_t len)
+{
+    uint32_t offset;
+    uint16_t n = len - 4;
+    uint8_t b;
+
+    if(!receiving || len <= 4 || n > UPLOAD_CHUNK) return UPLOAD_ERR_SEQUENCE;
+    if(fault) return fault;
+    offset = rd32(p);
+    /* Repeated after a lost reply */
+    if(offset < received && offset + n == received) return 0;
+    /* Whole words but for the last chunk */
+    if(offset != received || offset + n > length || ((n & 3) && offset + n != length))
+    {
+        return UPLOAD_ERR_SEQUENCE;
+    }
+    if(queued == 2) return UPLOAD_ERR_BUSY;
+
+    b = (head + queued) & 1;
+    memcpy(buf[b], p + 4, n);
+    memset(buf[b] + n, 0xFF, (4 - (n & 3)) & 3);
+    buflen[b] = n;
+    queued++;
+    received += n;
+
+    return 0;
+}
+
+static uint8_t end(uint16_t len)
+{
+    const uint8_t *song = UPLOAD_FLASH(slotaddr(slot) + UPLOAD_SLOT_HEADER);
+
+    if(len) return UPLOAD_ERR_SEQUENCE;
+    /* Repeated after a lost reply */
+    if(ended) return 0;
+    if(!receiving) return UPLOAD_ERR_SEQUENCE;
+    if(fault) return fault;
+    if(queued) return UPLOAD_ERR_BUSY;
+    if(received != length) return UPLOAD_ERR_SEQUENCE;
+
+    /* Checked by the engine before the header makes it the startup song;
+     * it switches at the next tick */
+    if(sum != crc || Chiptune_PlaySong(song, length) != HAL_OK)
+    {
+        fault = UPLOAD_ERR_SONG;
+        return fault;
+    }
+    if(commit() != HAL_OK) return UPLOAD_ERR_FLASH;
+
+    HAL_FLASH_Lock();
+    receiving = 0;
+    ended = 1;
+    stats.uploads++;
+
+    return 0;
+}
+
+static void reply(uint8_t type, uint8_t seq, uint8_t err)
+{
+    uint8_t out[8];
+
+    stream->write(out, Upload_Frame(out, type, seq, &err, type == UPLOAD_NAK));
+}
+
+static void handle(uint8_t type, uint8_t seq, const uint8_t *p, uint16_t len)
+{
+    uint8_t err;
+
+    switch(type)
+    {
+    case UPLOAD_BEGIN:
+        err = begin(p, len);
+        break;
+    case UPLOAD_DATA:
+        err = chunk(p, len);
+        break;
+    case UPLOAD_END:
+        err = end(len);
+        break;
+    default:
+        err = UPLOAD_ERR_SEQUENCE;
+        break;
+    }
+
+    /* The upload carries on after a refusal: a sender that gives up
+     * starts over with UPLOAD_BEGIN, or is timed out */
+    if(err == UPLOAD_ERR_BUSY) stats.busy++;
+    else if(err) stats.refused++;
+    lastframe = HAL_GetTick();
+    reply(err ? UPLOAD_NAK : UPLOAD_ACK, seq, err);
+}
+
+static void parse(uint8_t b)
+{
+    uint16_t len;
+
+    /* Bytes outside a frame are skipped */
+    if(!have && b != UPLOAD_SYNC) return;
+    frame[have++] = b;
+    if(have < 5) return;
+
+    len = rd16(frame + 3);
+    if(len > UPLOAD_FRAME_MAX - 7)
+    {
+        have = 0;
+        return;
+    }
+    if(have < 7 + len) return;
+
+    have = 0;
+    if(Upload_Crc16(frame + 1, 4 + len, 0xFFFF) != rd16(frame + 5 + len))
+    {
+        stats.damaged++;
+        reply(UPLOAD_NAK, frame[2], UPLOAD_ERR_CRC);
+        return;
+    }
+    stats.frames++;
+    handle(frame[1], frame[2], frame + 5, len);
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/*
+ * Call after Chiptune_Init() and before the audio starts: plays the newest
+ * stored song through Chiptune_PlaySong(), then erases the other slots
+ * that are not blank, stalling for each.
+ */
+void Upload_Init(const upload_transport_t *transport)
+{
+    uint32_t gen, newestgen = 0;
+    uint8_t n, newest = UPLOAD_SLOTS;
+
+    stream = transport;
+    have = 0;
+    receiving = ended = fault = 0;
+    memset(partlength, 0, sizeof(partlength));
+    queued = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    for(n = 0; n < UPLOAD_SLOTS; n++)
+    {
+        if(slotvalid(n, &gen) && (newest == UPLOAD_SLOTS || gen > newestgen))
+        {
+            newest = n;
+            newestgen = gen;
+        }
+    }
+    /* One the engine refuses is reclaimed with the rest */
+    if(newest < UPLOAD_SLOTS &&
+       Chiptune_PlaySong(UPLOAD_FLASH(slotaddr(newest) + UPLOAD_SLOT_HEADER),
+                         rd32(UPLOAD_FLASH(slotaddr(newest)) + HDR_LENGTH)) != HAL_OK)
+    {
+        newest = UPLOAD_SLOTS;
+    }
+    generation = newest < UPLOAD_SLOTS ? newestgen : 0;
+
+    HAL_FLASH_Unlock();
+    for(n = 0; n < UPLOAD_SLOTS; n++)
+    {
+        erased[n] = n != newest && (slotblank(n) || erase(n) == HAL_OK);
+    }
+    HAL_FLASH_Lock();
+}
+
+/*
+ * Main loop poll: takes the bytes received, replying to each frame, and
+ * programs up to UPLOAD_WORDS words of the chunks waiting. An upload that
+ * has had no frame for UPLOAD_TIMEOUT_MS is abandoned.
+ */
+void Upload_Process(void)
+{
+    uint8_t in[32];
+    uint16_t n, i;
+
+    while((n = stream->read(in, sizeof(in))) > 0)
+    {
+        for(i = 0; i < n; i++) parse(in[i]);
+    }
+    if(receiving && !fault) fault = program();
+    if(receiving && HAL_GetTick() - lastframe > UPLOAD_TIMEOUT_MS) abandon();
+}
+
+void Upload_GetStats(upload_stats_t *s)
+{
+    *s = stats;
+}
+
+/* Writes a frame of 'len' payload bytes to 'out', returns its size */
+uint16_t Upload_Frame(uint8_t *out, uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len)
+{
+    uint16_t check;
+
+    out[0] = UPLOAD_SYNC;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = len & 0xFF;
+    out[4] = len >> 8;
+    if(len) memcpy(out + 5, payload, len);
+    check = Upload_Crc16(out + 1, 4 + len, 0xFFFF);
+    out[5 + len] = check & 0xFF;
+    out[6 + len] = check >> 8;
+
+    return 7 + len;
+}
+
+/* CRC-16/CCITT (0x1021, from 0xFFFF); pass the last result to continue */
+uint16_t Upload_Crc16(const uint8_t *data, uint32_t len, uint16_t crc)
+{
+    uint8_t bit;
+
+    while(len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for(bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? crc << 1 ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+}
+
+/* CRC-32 as zlib's, from 0; pass the last result to continue */
+uint32_t Upload_Crc32(const uint8_t *data, uint32_t len, uint32_t crc)
+{
+    uint8_t bit;
+
+    crc = ~crc;
+    while(len--)
+    {
+        crc ^= *data++;
+        for(bit = 0; bit < 8; bit++) crc = crc & 1 ? crc >> 1 ^ 0xEDB88320u : crc >> 1;
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file           : adpcmenc.c
+  * @brief          : Encodes a 16-bit mono sample as an ADPCM sample_t header
+  ******************************************************************************
+  *
+  * Usage: adpcmenc [-f basefreq] [-l loopstart:looplen] input name > name.h
+  *
+  * input is a 16-bit mono PCM WAV file, or raw signed 16-bit little endian
+  * if it has no RIFF header. The generated header defines name_data[]
+  * (the ADPCM blocks) and NAME_SAMPLE, a sample_t initialiser for a
+  * bank: const sample_t bank[] = { KICK_SAMPLE, SNARE_SAMPLE };
+  *
+  * On stderr it reports the flash saving, the round-trip SNR and the host
+  * decode cost per frame. The firmware equivalent of the last figure is
+  * Chiptune_GetStats() adpcm, which counts cycles per decoded block.
+  *
+  */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+#include "adpcm.h"
+
+#define DEFAULT_BASEFREQ    0x0800  /* the engine's freq for 250 Hz */
+#define BENCH_PASSES        200
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+/* Returns the frames, or NULL with a message on stderr */
+static int16_t *loadpcm(const char *path, uint32_t *frames)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf, *pcm;
+    long size, pcmsize;
+    int16_t *out;
+    uint32_t i;
+
+    if(!f)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(size ? size : 1);
+    if(!buf || fread(buf, 1, size, f) != (size_t)size)
+    {
+        fprintf(stderr, "%s: read error\n", path);
+        fclose(f);
+        free(buf);
+        return NULL;
+    }
+    fclose(f);
+
+    pcm = buf;
+    pcmsize = size;
+    if(size >= 12 && !memcmp(buf, "RIFF", 4) && !memcmp(buf + 8, "WAVE", 4))
+    {
+        long pos = 12;
+
+        pcm = NULL;
+        while(pos + 8 <= size)
+        {
+            uint32_t len = rd32(buf + pos + 4);
+
+            if(!memcmp(buf + pos, "fmt ", 4) && len >= 16)
+            {
+                if(rd16(buf + pos + 8) != 1 || rd16(buf + pos + 10) != 1 || rd16(buf + pos + 22) != 16)
+                {
+                    fprintf(stderr, "%s: only 16-bit mono PCM WAV is supported\n", path);
+                    free(buf);
+                    return NULL;
+                }
+            }
+            else if(!memcmp(buf + pos, "data", 4))
+            {
+                pcm = buf + pos + 8;
+                pcmsize = (pos + 8 + (long)len <= size) ? (long)len : size - pos - 8;
+                break;
+            }
+            pos += 8 + len + (len & 1);
+        }
+        if(!pcm)
+        {
+            fprintf(stderr, "%s: no data chunk\n", path);
+            free(buf);
+            return NULL;
+        }
+    }
+
+    *frames = pcmsize / 2;
+    out = malloc((*frames ? *frames : 1) * sizeof(int16_t));
+    for(i = 0; i < *frames; i++)
+    {
+        out[i] = (int16_t)rd16(pcm + 2 * i);
+    }
+    free(buf);
+
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long basefreq = DEFAULT_BASEFREQ, loopstart = 0, looplen = 0;
+    uint32_t frames, blocks, i;
+    int16_t *pcm, *decoded;
+    uint8_t *data;
+    double noise = 0, signal = 0, ns;
+    struct timespec t0, t1;
+    int opt = 1, pass;
+
+    while(opt < argc && argv[opt][0] == '-')
+    {
+        if(!strcmp(argv[opt], "-f") && opt + 1 < argc)
+        {
+            basefreq = strtoul(argv[++opt], NULL, 0);
+        }
+        else if(!strcmp(argv[opt], "-l") && opt + 1 < argc)
+        {
+            if(sscanf(argv[++opt], "%lu:%lu", &loopstart, &looplen) != 2) break;
+        }
+        else break;
+        opt++;
+    }
+    if(argc - opt != 2 || !basefreq || basefreq > 0xffff)
+    {
+        fprintf(stderr, "usage: adpcmenc [-f basefreq] [-l loopstart:looplen] input name > name.h\n");
+        return 2;
+    }
+
+    pcm = loadpcm(argv[opt], &frames);
+    if(!pcm) return 1;
+    if(!frames || loopstart + looplen > frames)
+    {
+        fprintf(stderr, "adpcmenc: empty input or loop past the end (%u frames)\n", frames);
+        return 1;
+    }
+
+    blocks = (frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+    data = malloc(blocks * ADPCM_BLOCK_BYTES);
+    decoded = malloc(blocks * ADPCM_BLOCK_FRAMES * sizeof(int16_t));
+    for(i = 0; i < blocks; i++)
+    {
+        uint32_t first = i * ADPCM_BLOCK_FRAMES;
+        uint32_t n = frames - first < ADPCM_BLOCK_FRAMES ? frames - first : ADPCM_BLOCK_FRAMES;
+
+        ADPCM_EncodeBlock(pcm + first, n, data + i * ADPCM_BLOCK_BYTES);
+    }
+
+    /* Round trip quality and decoder cost */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for(i = 0; i < blocks; i++)
+        {
+            ADPCM_DecodeBlock(data + i * ADPCM_BLOCK_BYTES, decoded + i * ADPCM_BLOCK_FRAMES);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+         ((double)BENCH_PASSES * blocks * ADPCM_BLOCK_FRAMES);
+
+    for(i = 0; i < frames; i++)
+    {
+        double e = (double)decoded[i] - pcm[i];
+
+        noise += e * e;
+        signal += (double)pcm[i] * pcm[i];
+    }
+
+    printf("/* Generated by Tools/adpcmenc from %s - do not edit */\n\n", argv[argc - 2]);
+    printf("static const uint8_t %s_data[%u] = {", argv[argc - 1], blocks * ADPCM_BLOCK_BYTES);
+    for(i = 0; i < blocks * ADPCM_BLOCK_BYTES; i++)
+    {
+        printf("%s0x%02x%s", i % 12 ? " " : "\n    ", data[i], i + 1 < blocks * ADPCM_BLOCK_BYTES ? "," : "");
+    }
+    printf("\n};\n\n");
+    printf("#define ");
+    for(i = 0; argv[argc - 1][i]; i++) putchar(toupper((unsigned char)argv[argc - 1][i]));
+    printf("_SAMPLE \\\n    { %s_data, %u, %lu, %lu, 0x%04lx, SAMPLE_ADPCM }\n",
+           argv[argc - 1], frames, loopstart, looplen, basefreq);
+
+    fprintf(stderr, "%s: %u frames, %u bytes PCM16 -> %u bytes ADPCM (%.2fx)\n", argv[argc - 1],
+            frames, frames * 2, blocks * ADPCM_BLOCK_BYTES, frames * 2.0 / (blocks * ADPCM_BLOCK_BYTES));
+    fprintf(stderr, "  round-trip SNR %.1f dB, host decode %.2f ns/frame\n",
+            noise > 0 ? 10 * log10(signal / noise) : INFINITY, ns);
+
+    free(pcm);
+    free(decoded);
+    free(data);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file           : decimgen.c
+  * @brief          : Generates Core/Inc/decimfir.h, the oversampling FIR taps
+  ******************************************************************************
+  *
+  * Blackman-windowed sinc low-pass, cut off just below the output Nyquist
+  * frequency, quantised to Q15 with the DC gain forced to exactly 1.0.
+  * Tap counts are a multiple of the oversampling factor and even, so the
+  * engine's dual-MAC inner loop always reads aligned tap pairs.
+  *
+  * Usage: decimgen [taps-per-phase] > decimfir.h
+  *
+  */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CUTOFF          0.45    /* -6 dB point, fraction of the output rate */
+#define MAX_TAPS        256
+
+static void gentaps(int factor, int taps, int16_t *q)
+{
+    double h[MAX_TAPS];
+    double sum = 0, fc = CUTOFF / factor;
+    long total = 0;
+    int n;
+
+    for(n = 0; n < taps; n++)
+    {
+        double t = n - (taps - 1) / 2.0;
+        double w = 0.42 - 0.5 * cos(2 * M_PI * n / (taps - 1)) + 0.08 * cos(4 * M_PI * n / (taps - 1));
+
+        h[n] = 2 * fc * (t == 0 ? 1.0 : sin(2 * M_PI * fc * t) / (2 * M_PI * fc * t)) * w;
+        sum += h[n];
+    }
+
+    for(n = 0; n < taps; n++)
+    {
+        q[n] = (int16_t)lrint(h[n] / sum * 32768.0);
+        total += q[n];
+    }
+
+    /* Put the rounding residue on the two centre taps, keeping symmetry */
+    q[taps / 2 - 1] += (int16_t)((32768 - total) / 2);
+    q[taps / 2] += (int16_t)((32768 - total) - (32768 - total) / 2);
+}
+
+static void emit(int factor, int taps)
+{
+    int16_t q[MAX_TAPS];
+    int n;
+
+    gentaps(factor, taps, q);
+
+    printf("#define DECIM%d_TAPS            %d\n\n", factor, taps);
+    printf("static const int16_t decim%d_taps[DECIM%d_TAPS] __attribute__((aligned(4))) = {", factor, factor);
+    for(n = 0; n < taps; n++)
+    {
+        printf("%s%6d%s", n % 8 ? " " : "\n   ", q[n], n + 1 < taps ? "," : "");
+    }
+    printf("\n};\n\n");
+}
+
+int main(int argc, char **argv)
+{
+    int perphase = argc > 1 ? atoi(argv[1]) : 12;
+
+    if(perphase < 2 || perphase * 4 > MAX_TAPS || perphase & 1)
+    {
+        fprintf(stderr, "decimgen: taps per phase must be even, 2..%d\n", MAX_TAPS / 4);
+        return 1;
+    }
+
+    printf("/**\n");
+    printf("  ******************************************************************************\n");
+    printf("  * @file           : decimfir.h\n");
+    printf("  * @brief          : Oversampling decimation FIR taps (Q15)\n");
+    printf("  ******************************************************************************\n");
+    printf("  *\n");
+    printf("  * Generated by Tools/decimgen %d - do not edit, run 'make -C Tools fir'.\n", perphase);
+    printf("  *\n");
+    printf("  */\n\n");
+    printf("#ifndef __DECIMFIR_H\n");
+    printf("#define __DECIMFIR_H\n\n");
+    printf("#include <stdint.h>\n\n");
+    emit(2, 2 * perphase);
+    emit(4, 4 * perphase);
+    printf("#endif /* __DECIMFIR_H */\n");
+
+    return 0;
+}
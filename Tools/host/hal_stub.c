@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file           : hal_stub.c
+  * @brief          : Storage and flash for the host HAL stand-in
+  ******************************************************************************
+  */
+
+#include <string.h>
+
+#include "stm32f4xx_hal.h"
+
+GPIO_TypeDef hal_stub_gpio;
+
+uint8_t hal_stub_flash[HAL_STUB_FLASH_SIZE];
+uint32_t hal_stub_flash_erases;
+uint32_t hal_stub_flash_words;
+uint32_t hal_stub_tick;
+
+static uint8_t flashlocked = 1;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    flashlocked = 0;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    flashlocked = 1;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    uint8_t *p = hal_stub_flash + (Address - HAL_STUB_FLASH_BASE);
+    uint8_t i;
+
+    if(flashlocked || TypeProgram != FLASH_TYPEPROGRAM_WORD || (Address & 3) ||
+       Address < HAL_STUB_FLASH_BASE || Address - HAL_STUB_FLASH_BASE > HAL_STUB_FLASH_SIZE - 4)
+    {
+        return HAL_ERROR;
+    }
+    for(i = 0; i < 4; i++) p[i] &= (uint8_t)(Data >> 8 * i);
+    hal_stub_flash_words++;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError)
+{
+    uint32_t s;
+
+    *SectorError = 0xFFFFFFFFU;
+    for(s = pEraseInit->Sector; s < pEraseInit->Sector + pEraseInit->NbSectors; s++)
+    {
+        if(flashlocked || s < FLASH_SECTOR_10 || s > FLASH_SECTOR_11)
+        {
+            *SectorError = s;
+            return HAL_ERROR;
+        }
+        memset(hal_stub_flash + (s - FLASH_SECTOR_10) * (HAL_STUB_FLASH_SIZE / 2), 0xFF, HAL_STUB_FLASH_SIZE / 2);
+        hal_stub_flash_erases++;
+    }
+
+    return HAL_OK;
+}
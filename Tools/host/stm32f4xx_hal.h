@@ -0,0 +1,141 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f4xx_hal.h
+  * @brief          : Host stand-in for the HAL, lets the engine build natively
+  ******************************************************************************
+  *
+  * Only what Core/Src/chiptune.c and upload.c touch is provided. GPIO
+  * writes are dropped; the engine keeps time by the samples the tools
+  * render, and the HAL tick, which only upload.c reads, is whatever the
+  * tool sets. The flash is backed only where the song slots are.
+  *
+  */
+
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t ODR;
+} GPIO_TypeDef;
+
+/* Engine state and the tick are per thread, so tools can run an engine on
+ * each; there is no CCM to place tables in */
+#define CHIPTUNE_TLS            _Thread_local
+#define CCMRAM
+
+extern GPIO_TypeDef hal_stub_gpio;
+
+#define GPIOA                   (&hal_stub_gpio)
+#define GPIOB                   (&hal_stub_gpio)
+#define GPIOC                   (&hal_stub_gpio)
+#define GPIOD                   (&hal_stub_gpio)
+#define GPIOE                   (&hal_stub_gpio)
+#define GPIOH                   (&hal_stub_gpio)
+
+#define GPIO_PIN_0              ((uint16_t)0x0001)
+#define GPIO_PIN_1              ((uint16_t)0x0002)
+#define GPIO_PIN_2              ((uint16_t)0x0004)
+#define GPIO_PIN_3              ((uint16_t)0x0008)
+#define GPIO_PIN_4              ((uint16_t)0x0010)
+#define GPIO_PIN_5              ((uint16_t)0x0020)
+#define GPIO_PIN_6              ((uint16_t)0x0040)
+#define GPIO_PIN_7              ((uint16_t)0x0080)
+#define GPIO_PIN_8              ((uint16_t)0x0100)
+#define GPIO_PIN_9              ((uint16_t)0x0200)
+#define GPIO_PIN_10             ((uint16_t)0x0400)
+#define GPIO_PIN_11             ((uint16_t)0x0800)
+#define GPIO_PIN_12             ((uint16_t)0x1000)
+#define GPIO_PIN_13             ((uint16_t)0x2000)
+#define GPIO_PIN_14             ((uint16_t)0x4000)
+#define GPIO_PIN_15             ((uint16_t)0x8000)
+
+static inline void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    (void)port;
+    (void)pin;
+    (void)state;
+}
+
+static inline void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    (void)port;
+    (void)pin;
+}
+
+/* Flash: sectors 10 and 11, HAL_STUB_FLASH_BASE on, in hal_stub_flash.
+ * Programming can only clear bits, as on the part, and the calls are
+ * counted so tools can check when erases happen. */
+#define FLASH_TYPEERASE_SECTORS 0x00U
+#define FLASH_TYPEPROGRAM_WORD  0x02U
+#define FLASH_VOLTAGE_RANGE_3   0x02U
+#define FLASH_SECTOR_10         10U
+#define FLASH_SECTOR_11         11U
+
+#define FLASH_FLAG_EOP          0x01U
+#define FLASH_FLAG_OPERR        0x02U
+#define FLASH_FLAG_WRPERR       0x10U
+#define FLASH_FLAG_PGAERR       0x20U
+#define FLASH_FLAG_PGPERR       0x40U
+#define FLASH_FLAG_PGSERR       0x80U
+#define __HAL_FLASH_CLEAR_FLAG(flags) ((void)(flags))
+
+#define HAL_STUB_FLASH_BASE     0x080C0000U
+#define HAL_STUB_FLASH_SIZE     0x40000U
+
+typedef struct {
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t Sector;
+    uint32_t NbSectors;
+    uint32_t VoltageRange;
+} FLASH_EraseInitTypeDef;
+
+extern uint8_t hal_stub_flash[HAL_STUB_FLASH_SIZE];
+extern uint32_t hal_stub_flash_erases;
+extern uint32_t hal_stub_flash_words;
+
+/* Flash address to memory, for upload.c's reads */
+#define UPLOAD_FLASH(addr)      ((const uint8_t *)hal_stub_flash + ((addr) - HAL_STUB_FLASH_BASE))
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError);
+
+/* Milliseconds, set by the tool */
+extern uint32_t hal_stub_tick;
+
+static inline uint32_t HAL_GetTick(void)
+{
+    return hal_stub_tick;
+}
+
+/* No interrupts on the host: each engine is called from its own thread */
+#define __disable_irq()         ((void)0)
+#define __enable_irq()          ((void)0)
+#define __DMB()                 __sync_synchronize()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_HAL_H */
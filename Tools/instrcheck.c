@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file           : instrcheck.c
+  * @brief          : Worst-case instrument commands per sequencer tick
+  ******************************************************************************
+  *
+  * Usage: instrcheck song...
+  *
+  * Each song is a container or a track.h-format header. For every
+  * instrument it prints the most commands playroutine can run for it in
+  * one tick (songfile_instrcost()), and flags programs that loop without
+  * waiting, which would hang a sequencer without CHIPTUNE_INSTR_BUDGET.
+  * The worst tick is every channel running the costliest instrument.
+  *
+  * Exits 1 if a program runs away or exceeds CHIPTUNE_INSTR_BUDGET, where
+  * the firmware would cut it short and count an overrun.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+
+int main(int argc, char **argv)
+{
+    int i, bad = 0;
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: instrcheck song...\n");
+        return 2;
+    }
+
+    for(i = 1; i < argc; i++)
+    {
+        uint32_t len;
+        uint8_t *song = songfile_load(argv[i], &len);
+        uint16_t worst = 0;
+        uint8_t num;
+
+        if(!song)
+        {
+            bad = 1;
+            continue;
+        }
+        printf("%s:", argv[i]);
+        for(num = 1; num <= song[4]; num++)
+        {
+            uint16_t n = songfile_instrcost(song, len, num);
+
+            if(n == INSTR_RUNAWAY) printf(" %x:loops", num);
+            else printf(" %x:%u", num, n);
+            if(n > CHIPTUNE_INSTR_BUDGET) bad = 1;
+            if(n > worst) worst = n;
+        }
+        if(worst == INSTR_RUNAWAY)
+        {
+            printf("\n  runaway program: unbounded without the budget, %u commands per channel with it\n",
+                   CHIPTUNE_INSTR_BUDGET);
+        }
+        else
+        {
+            printf("\n  worst tick %u commands (%u per channel, budget %u)%s\n", worst * CHIPTUNE_CHANNELS,
+                   worst, CHIPTUNE_INSTR_BUDGET, worst > CHIPTUNE_INSTR_BUDGET ? ", over budget" : "");
+        }
+        free(song);
+    }
+
+    return bad;
+}
@@ -0,0 +1,357 @@
+/**
+  ******************************************************************************
+  * @file           : midibench.c
+  * @brief          : Checks the MIDI input path and measures its latency
+  ******************************************************************************
+  *
+  * Usage: midibench [-n notes]
+  *
+  * Feeds MIDI bytes to Core/Src/midi.c through a stand-in for the UART and
+  * its receive DMA, and runs the main loop as the firmware does: a
+  * Midi_Process() and Chiptune_Process() poll every millisecond, the audio
+  * interrupt every sample, and the I2S DMA sends the ring AUDIO_WRITE_LEAD
+  * frames behind the interrupt's writes, as main.c starts it.
+  *
+  * First it plays one phrase encoded three ways - a status byte on every
+  * message, running status with zero-velocity note offs, and that again
+  * with real-time bytes between all bytes and a system exclusive message
+  * before every fourth - each message arriving whole at the same samples,
+  * and checks the three renders are identical.
+  *
+  * Next it sends more than MIDI_RX_SIZE bytes between two polls, which
+  * must count one overrun, and a message after them, which must be parsed.
+  *
+  * Then it plays notes at the wire rate at random times over the song and
+  * finds the first sample the DMA sends that differs from the song alone.
+  * The input-to-audio latency, from the end of a note on's last byte to
+  * that sample, must stay below one DMA half-buffer, the audio the codec
+  * holds. The engine's own share, from the interrupt stamp to the poll
+  * that applies it, is Chiptune_GetStats() livelatency on the board as
+  * here; AUDIO_WRITE_LEAD frames of the rest are the mixer's lead on the
+  * DMA.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chiptune.h"
+#include "midi.h"
+
+#define POLL_FRAMES     (CHIPTUNE_SAMPLE_RATE / 1000)   /* main loop HAL_Delay(1) */
+#define AUDIO_FRAMES    (AUDIO_BUFFER_SIZE / 2)          /* frames in the DMA ring */
+#define HALF_BUFFER     (AUDIO_FRAMES / 2)               /* frames per DMA half */
+#define BYTE_FRAMES     (10.0 * CHIPTUNE_SAMPLE_RATE / MIDI_BAUD)
+#define PHRASE_FRAMES   (3 * CHIPTUNE_SAMPLE_RATE)
+#define SONG_FRAMES     (20 * CHIPTUNE_SAMPLE_RATE)
+#define MAX_BYTES       2048
+#define MAX_NOTES       10000
+
+/*
+ * Byte-stream stand-in for the UART and its receive DMA: each byte lands
+ * in the Midi_GetRxBuffer() ring as its stop bit ends, and the DMA half
+ * and full marks and the idle line (a character after the last byte)
+ * call Midi_RxInterrupt() as those interrupts would. With no byte time a
+ * message arrives whole.
+ */
+typedef struct {
+    uint8_t byte[MAX_BYTES];
+    double end[MAX_BYTES];    /* frame its stop bit ends */
+    uint16_t count, sent;
+    double bytetime;
+    double lastend;
+    uint16_t dma;
+    uint8_t pending;          /* bytes since the last idle interrupt */
+} uart_t;
+
+/* A channel message of the phrase */
+typedef struct {
+    uint32_t time;
+    uint8_t status;
+    uint8_t data[2];
+} msg_t;
+
+static const msg_t phrase[] = {
+    {     0, 0xC1, { 2 } },
+    {     0, 0xB0, { 7, 100 } },
+    {   400, 0x90, { 60, 100 } },
+    {   400, 0x91, { 48, 90 } },
+    {  2000, 0x80, { 60, 0 } },
+    {  2000, 0x90, { 64, 110 } },
+    {  3600, 0xB1, { 10, 20 } },
+    {  3600, 0xE0, { 0x00, 0x50 } },
+    {  5200, 0xE0, { 0x00, 0x40 } },
+    {  5200, 0x80, { 64, 0 } },
+    {  5200, 0x90, { 67, 127 } },
+    {  5200, 0x92, { 72, 60 } },
+    {  7000, 0xB0, { 1, 90 } },
+    {  7000, 0xB2, { 74, 30 } },
+    {  8800, 0x80, { 67, 64 } },
+    {  8800, 0x81, { 48, 0 } },
+    { 10400, 0x91, { 55, 100 } },
+    { 12000, 0xB0, { 121, 0 } },
+    { 12000, 0xB1, { 123, 0 } },
+    { 12000, 0x82, { 72, 0 } },
+};
+
+#define PHRASE_LEN      (sizeof(phrase) / sizeof(phrase[0]))
+
+/* Encodings of the phrase */
+#define ENC_STATUS      0   /* a status byte on every message */
+#define ENC_RUNNING     1   /* running status, note offs as velocity 0 */
+#define ENC_NOISY       2   /* running, real-time and system exclusive bytes between */
+
+static void uartinit(uart_t *u, double bytetime)
+{
+    memset(u, 0, sizeof(*u));
+    u->bytetime = bytetime;
+    u->lastend = -1e9;
+}
+
+/* Queue bytes to start at frame 'time', or after those still queued */
+static void uartsend(uart_t *u, const uint8_t *b, uint16_t n, double time)
+{
+    double t = u->count ? u->end[u->count - 1] : time;
+
+    if(t < time) t = time;
+    if(u->count + n > MAX_BYTES)
+    {
+        fprintf(stderr, "midibench: stand-in queue full\n");
+        exit(1);
+    }
+    while(n--)
+    {
+        t += u->bytetime;
+        u->byte[u->count] = *b++;
+        u->end[u->count++] = t;
+    }
+}
+
+/* Delivers what the wire has finished by frame n */
+static void uartstep(uart_t *u, uint32_t n)
+{
+    uint8_t *ring = Midi_GetRxBuffer();
+
+    while(u->sent < u->count && u->end[u->sent] <= n)
+    {
+        ring[u->dma] = u->byte[u->sent];
+        u->lastend = u->end[u->sent++];
+        u->dma = (u->dma + 1) % MIDI_RX_SIZE;
+        u->pending = 1;
+        if(u->dma % (MIDI_RX_SIZE / 2) == 0) Midi_RxInterrupt(u->dma);
+    }
+    /* Idle once a character passes with no start bit */
+    if(u->pending && n >= u->lastend + u->bytetime &&
+       (u->sent == u->count || u->end[u->sent] - u->bytetime >= u->lastend + u->bytetime))
+    {
+        Midi_RxInterrupt(u->dma);
+        u->pending = 0;
+    }
+}
+
+/* One frame of main loop and audio interrupt; returns the L/R frame the
+ * DMA sends, the one mixed AUDIO_WRITE_LEAD frames ago */
+static uint32_t step(uart_t *u, uint32_t n)
+{
+    const uint16_t *buf = getAudioBuffer();
+    uint32_t i = 2 * ((n + AUDIO_FRAMES - AUDIO_WRITE_LEAD) % AUDIO_FRAMES);
+
+    uartstep(u, n);
+    if(n % POLL_FRAMES == 0)
+    {
+        Midi_Process();
+        Chiptune_Process();
+    }
+    Chiptune_AudioCallback();
+
+    return buf[i] | (uint32_t)buf[i + 1] << 16;
+}
+
+static void start(void)
+{
+    Chiptune_Init();
+    Midi_Init();
+}
+
+static uint16_t encode(const msg_t *m, uint8_t enc, uint8_t *last, uint8_t *out)
+{
+    static const uint8_t sysex[] = { 0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7 };
+    uint8_t raw[3], n = 0, i, len = (m->status & 0xE0) == 0xC0 ? 2 : 3;
+    uint16_t k = 0;
+
+    raw[0] = m->status;
+    raw[1] = m->data[0];
+    raw[2] = m->data[1];
+    if(enc != ENC_STATUS && (raw[0] & 0xF0) == 0x80)
+    {
+        raw[0] = 0x90 | (raw[0] & 15);
+        raw[2] = 0;
+    }
+    if(enc == ENC_NOISY && (m - phrase) % 4 == 3)
+    {
+        memcpy(out, sysex, sizeof(sysex));
+        k = sizeof(sysex);
+        *last = 0;
+    }
+    for(i = enc != ENC_STATUS && raw[0] == *last; i < len; i++)
+    {
+        if(enc == ENC_NOISY) out[k++] = n++ & 1 ? 0xFE : 0xF8;
+        out[k++] = raw[i];
+    }
+    *last = raw[0];
+
+    return k;
+}
+
+/* Renders the phrase in one encoding, each message arriving whole */
+static void renderphrase(uint8_t enc, uint32_t *frames, uint32_t *messages)
+{
+    uart_t u;
+    uint8_t bytes[32], last = 0;
+    uint32_t n, i;
+    midi_stats_t st;
+
+    start();
+    uartinit(&u, 0);
+    for(i = 0; i < PHRASE_LEN; i++)
+    {
+        uartsend(&u, bytes, encode(&phrase[i], enc, &last, bytes), phrase[i].time);
+    }
+    for(n = 0; n < PHRASE_FRAMES; n++) frames[n] = step(&u, n);
+    Midi_GetStats(&st);
+    *messages = st.messages;
+}
+
+static int encodings(void)
+{
+    static uint32_t frames[3][PHRASE_FRAMES];
+    uint32_t messages[3];
+    uint8_t enc;
+    int failed = 0;
+
+    for(enc = ENC_STATUS; enc <= ENC_NOISY; enc++) renderphrase(enc, frames[enc], &messages[enc]);
+    for(enc = ENC_RUNNING; enc <= ENC_NOISY; enc++)
+    {
+        if(messages[enc] != PHRASE_LEN || memcmp(frames[enc], frames[ENC_STATUS], sizeof(frames[0])))
+        {
+            failed = 1;
+        }
+    }
+    fprintf(stderr, "parser: %s\n", failed || messages[ENC_STATUS] != PHRASE_LEN ? "FAILED" :
+            "running status, real-time and system exclusive bytes render as plain messages");
+
+    return failed || messages[ENC_STATUS] != PHRASE_LEN;
+}
+
+/* More than the ring before a poll, then a message that must be parsed */
+static int overrun(void)
+{
+    static const uint8_t after[] = { 0x91, 48, 100 };
+    uart_t u;
+    uint8_t burst[MIDI_RX_SIZE + 4];
+    uint32_t n;
+    midi_stats_t st;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(burst); i++) burst[i] = i % 3 ? 60 : 0x90;
+    start();
+    uartinit(&u, 0);
+    uartsend(&u, burst, sizeof(burst), 1);
+    uartsend(&u, after, sizeof(after), POLL_FRAMES * 10);
+    for(n = 0; n < POLL_FRAMES * 20; n++) step(&u, n);
+    Midi_GetStats(&st);
+
+    if(st.overruns != 1 || st.messages != 1)
+    {
+        fprintf(stderr, "overrun: FAILED (%u overruns, %u messages)\n", st.overruns, st.messages);
+        return 1;
+    }
+    fprintf(stderr, "overrun: %u bytes between polls counted and dropped, the next message parsed\n",
+            (unsigned)sizeof(burst));
+
+    return 0;
+}
+
+/* Plays notes at random times over the song, one engine run each */
+static int latency(uint32_t notes)
+{
+    static uint32_t song[SONG_FRAMES];
+    uart_t u;
+    uint32_t n, k, seed = 1, heard = 0, worstengine = 0;
+    double total = 0, worst = 0;
+    chiptune_stats_t st;
+
+    start();
+    uartinit(&u, BYTE_FRAMES);
+    for(n = 0; n < SONG_FRAMES; n++) song[n] = step(&u, n);
+
+    for(k = 0; k < notes; k++)
+    {
+        uint8_t program[2], msg[3];
+        uint32_t at;
+        double end;
+
+        seed = seed * 1103515245 + 12345;
+        at = CHIPTUNE_SAMPLE_RATE + (seed >> 8) % (SONG_FRAMES - 2 * CHIPTUNE_SAMPLE_RATE);
+        msg[0] = 0x90 | (seed >> 4) % CHIPTUNE_CHANNELS;
+        msg[1] = 48 + (seed >> 12) % 36;
+        msg[2] = 64 + (seed >> 20) % 64;
+        /* Instrument 3 is a pulse from its first tick, so the note does not
+         * pass for the song's own noise or a retrigger; the program change
+         * posts nothing, the song plays on as without it */
+        program[0] = 0xC0 | (msg[0] & 15);
+        program[1] = 2;
+
+        start();
+        uartinit(&u, BYTE_FRAMES);
+        uartsend(&u, program, sizeof(program), 0);
+        uartsend(&u, msg, sizeof(msg), at);
+        end = u.end[4];
+        for(n = 0; n < at; n++) step(&u, n);
+        for(; n < SONG_FRAMES && step(&u, n) == song[n]; n++);
+        if(n == SONG_FRAMES)
+        {
+            fprintf(stderr, "midibench: note %u at frame %u never heard\n", k, at);
+            return 1;
+        }
+        total += n - end;
+        if(n - end > worst) worst = n - end;
+        heard++;
+        Chiptune_GetStats(&st);
+        if(st.livelatency > worstengine) worstengine = st.livelatency;
+    }
+
+    fprintf(stderr, "%u notes: input-to-audio latency %.2f ms average, %.2f ms worst "
+            "(%.1f frames; DMA half-buffer %u frames, %.1f ms)\n",
+            heard, total * 1000.0 / heard / CHIPTUNE_SAMPLE_RATE, worst * 1000.0 / CHIPTUNE_SAMPLE_RATE,
+            worst, HALF_BUFFER, HALF_BUFFER * 1000.0 / CHIPTUNE_SAMPLE_RATE);
+    fprintf(stderr, "  of which interrupt stamp to poll: %u frames worst (livelatency), "
+            "mixer to DMA: %u frames (AUDIO_WRITE_LEAD)\n", worstengine, AUDIO_WRITE_LEAD);
+    if(worst >= HALF_BUFFER)
+    {
+        fprintf(stderr, "midibench: latency over a DMA half-buffer\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long notes = 200;
+
+    if(argc == 3 && !strcmp(argv[1], "-n"))
+    {
+        notes = strtoul(argv[2], NULL, 0);
+    }
+    if((argc != 1 && argc != 3) || !notes || notes > MAX_NOTES)
+    {
+        fprintf(stderr, "usage: midibench [-n notes]\n");
+        return 2;
+    }
+
+    if(encodings() || overrun()) return 1;
+
+    return latency(notes);
+}
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file           : mixbench.c
+  * @brief          : Measures the stereo mixer's cost against the mono mixer
+  ******************************************************************************
+  *
+  * Usage: mixbench [-s seconds]
+  *
+  * Plays the built-in song with its channels panned apart and times the
+  * audio callback, keeping the fastest of a few runs. Built as mixbench it
+  * measures the packed L/R mixer (CHIPTUNE_STEREO), as mixbench-mono the
+  * mono one; make -C Tools mixcost runs both. On the board,
+  * Chiptune_GetStats() mix with CHIPTUNE_PROFILE has the cycles.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chiptune.h"
+
+#define POLL_FRAMES     (CHIPTUNE_SAMPLE_RATE / 1000)   /* main loop HAL_Delay(1) */
+#define MAX_SECONDS     3600
+#define RUNS            5       /* timings, the fastest is kept */
+
+/* Hard left to hard right, so neither lane's gain is the centre's */
+static const uint8_t pans[CHIPTUNE_CHANNELS] = { PAN_LEFT, 0x60, 0xa0, PAN_RIGHT };
+
+static double elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+/* Host ns per output sample of the song */
+static double cost(uint32_t frames)
+{
+    struct timespec t0, t1;
+    uint32_t n;
+    uint8_t ch;
+
+    Chiptune_Init();
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++) Chiptune_SetPan(ch, pans[ch]);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(n = 0; n < frames; n++)
+    {
+        if(n % POLL_FRAMES == 0) Chiptune_Process();
+        Chiptune_AudioCallback();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    return elapsed(&t0, &t1) / frames;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long seconds = 60;
+    double ns = 0;
+    uint8_t r;
+
+    if(argc == 3 && !strcmp(argv[1], "-s"))
+    {
+        seconds = strtoul(argv[2], NULL, 0);
+    }
+    if((argc != 1 && argc != 3) || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: mixbench [-s seconds]\n");
+        return 2;
+    }
+
+    for(r = 0; r < RUNS; r++)
+    {
+        double t = cost(seconds * CHIPTUNE_SAMPLE_RATE);
+
+        if(!r || t < ns) ns = t;
+    }
+
+    printf("%s mixer, %u Hz render (%ux), %lu s of the song: %.1f host ns per output sample\n",
+           CHIPTUNE_STEREO ? "stereo" : "mono", CHIPTUNE_SAMPLE_RATE * CHIPTUNE_OVERSAMPLE,
+           CHIPTUNE_OVERSAMPLE, seconds, ns);
+
+    return 0;
+}
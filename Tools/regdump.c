@@ -0,0 +1,246 @@
+/**
+  ******************************************************************************
+  * @file           : regdump.c
+  * @brief          : Records the song as a register dump for CHIPTUNE_REPLAY
+  ******************************************************************************
+  *
+  * Usage: regdump [-s seconds] > regdump.h
+  *
+  * Runs playroutine through Chiptune_Tick() tick by tick, without the
+  * mixer, and after every tick stores which oscillator registers changed
+  * (format in chiptune.h, REGDUMP_*). A CHIPTUNE_REPLAY build applies the
+  * records through Chiptune_PlayDump() instead of unpacking tracks and
+  * interpreting instruments, and produces the same output sample for
+  * sample.
+  *
+  * Only what playroutine writes is recorded; the derived gain and sample
+  * step are recomputed by the replay. Sample numbers are relative to the
+  * bank registered here, which is none, like Tools/render. The format has
+  * no field for the filter, so a song that turns it on is refused.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chiptune.h"
+
+#define TICKS_PER_SEC   (CHIPTUNE_TEMPO * 2 / 5)
+#define TAIL_TICKS      TICKS_PER_SEC
+#define MAX_SECONDS     3600
+
+typedef struct {
+    uint16_t freq;
+    uint16_t duty;
+    uint8_t  waveform;
+    uint8_t  volume;
+    uint8_t  pan;
+    uint8_t  table;
+    uint8_t  sample;
+} regs_t;
+
+static uint8_t *out;
+static uint32_t outlen, outcap;
+
+static void put(uint8_t b)
+{
+    if(outlen == outcap)
+    {
+        outcap = outcap ? outcap * 2 : 4096;
+        out = realloc(out, outcap);
+    }
+    out[outlen++] = b;
+}
+
+static void readregs(regs_t *r, const wavetable_t *table0)
+{
+    uint8_t ch;
+
+    for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+    {
+        r[ch].freq = osc[ch].freq;
+        r[ch].duty = osc[ch].duty;
+        r[ch].waveform = osc[ch].waveform;
+        r[ch].volume = osc[ch].volume;
+        r[ch].pan = osc[ch].pan;
+        r[ch].table = (uint8_t)(osc[ch].table - table0);
+        r[ch].sample = 0xff;
+    }
+}
+
+/* Encodes one channel's changes, returns its field mask (0 = none) */
+static uint8_t encode(const regs_t *prev, const regs_t *cur, uint8_t retrigger, uint8_t *rec, uint8_t *len)
+{
+    int16_t delta = (int16_t)(cur->freq - prev->freq);
+    uint8_t f = 0, n = 0;
+
+    if(delta && delta >= -128 && delta <= 127)
+    {
+        f |= REGDUMP_FREQ_DELTA;
+    }
+    else if(delta)
+    {
+        f |= REGDUMP_FREQ;
+        rec[n++] = cur->freq & 0xff;
+        rec[n++] = cur->freq >> 8;
+    }
+    if(f & REGDUMP_FREQ_DELTA) rec[n++] = (uint8_t)delta;
+    if(cur->duty != prev->duty)
+    {
+        f |= REGDUMP_DUTY;
+        rec[n++] = cur->duty & 0xff;
+        rec[n++] = cur->duty >> 8;
+    }
+    if(cur->waveform != prev->waveform)
+    {
+        f |= REGDUMP_WAVEFORM;
+        rec[n++] = cur->waveform;
+    }
+    if(cur->volume != prev->volume)
+    {
+        f |= REGDUMP_VOLUME;
+        rec[n++] = cur->volume;
+    }
+    if(cur->pan != prev->pan)
+    {
+        f |= REGDUMP_PAN;
+        rec[n++] = cur->pan;
+    }
+    if(cur->table != prev->table)
+    {
+        f |= REGDUMP_TABLE;
+        rec[n++] = cur->table;
+    }
+    if(retrigger)
+    {
+        f |= REGDUMP_SAMPLE;
+        rec[n++] = cur->sample;
+    }
+
+    *len = n;
+    return f;
+}
+
+int main(int argc, char **argv)
+{
+    regs_t prev[CHIPTUNE_CHANNELS], cur[CHIPTUNE_CHANNELS];
+    const wavetable_t *table0;
+    unsigned long seconds = MAX_SECONDS;
+    uint32_t ticks = 0, maxticks, songticks = 0, worst = 0, last = 0;
+    struct timespec t0, t1;
+    double ns, replayns;
+    regdump_t dump;
+    uint32_t i;
+    uint8_t ch;
+
+    if(argc == 3 && !strcmp(argv[1], "-s"))
+    {
+        seconds = strtoul(argv[2], NULL, 0);
+    }
+    if((argc != 1 && argc != 3) || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: regdump [-s seconds] > regdump.h\n");
+        return 2;
+    }
+    maxticks = seconds * TICKS_PER_SEC;
+
+    Chiptune_Init();
+    table0 = osc[0].table;
+    readregs(prev, table0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while(ticks < maxticks && (!songticks || ticks < songticks + TAIL_TICKS))
+    {
+        uint8_t rec[CHIPTUNE_CHANNELS][10], len[CHIPTUNE_CHANNELS], fields[CHIPTUNE_CHANNELS];
+        uint8_t trigger[CHIPTUNE_CHANNELS];
+        uint8_t mask = 0;
+
+        /* Command 'k' bumps the trigger */
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++) trigger[ch] = osc[ch].trigger;
+
+        Chiptune_Tick();
+        ticks++;
+        if(!songticks && !Chiptune_IsPlaying()) songticks = ticks;
+
+        readregs(cur, table0);
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            if(osc[ch].filter & FILTER_MODES)
+            {
+                fprintf(stderr, "regdump: channel %u turns the filter on at tick %u, "
+                        "which a register dump does not carry\n", ch, ticks);
+                return 1;
+            }
+            fields[ch] = encode(&prev[ch], &cur[ch], osc[ch].trigger != trigger[ch], rec[ch], &len[ch]);
+            if(fields[ch]) mask |= 1 << ch;
+        }
+        memcpy(prev, cur, sizeof(prev));
+
+        /* Unchanged ticks extend the previous record's run */
+        if(!mask && outlen && (out[last] >> 4) < 15)
+        {
+            out[last] += 0x10;
+            continue;
+        }
+
+        last = outlen;
+        put(mask);
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            uint8_t i;
+
+            if(!fields[ch]) continue;
+            put(fields[ch]);
+            for(i = 0; i < len[ch]; i++) put(rec[ch][i]);
+        }
+        if(outlen - last > worst) worst = outlen - last;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ticks;
+
+    /* Same ticks again, replayed from the dump */
+    dump.data = out;
+    dump.length = outlen;
+    dump.songticks = songticks ? songticks : ticks;
+    Chiptune_Init();
+    Chiptune_PlayDump(&dump);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(i = 0; i < ticks; i++)
+    {
+        Chiptune_Tick();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    replayns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ticks;
+
+    printf("/**\n");
+    printf("  ******************************************************************************\n");
+    printf("  * @file           : regdump.h\n");
+    printf("  * @brief          : Song as oscillator register dump for CHIPTUNE_REPLAY builds\n");
+    printf("  ******************************************************************************\n");
+    printf("  *\n");
+    printf("  * Generated by Tools/regdump - do not edit, run 'make -C Tools regdump'.\n");
+    printf("  *\n");
+    printf("  */\n\n");
+    printf("#ifndef __REGDUMP_H\n");
+    printf("#define __REGDUMP_H\n\n");
+    printf("#include \"chiptune.h\"\n\n");
+    printf("#define REGDUMP_TICKS           %u\n", ticks);
+    printf("#define REGDUMP_BYTES           %u\n\n", outlen);
+    printf("static const uint8_t regdump_data[REGDUMP_BYTES] = {");
+    for(i = 0; i < outlen; i++)
+    {
+        printf("%s0x%02x%s", i % 12 ? " " : "\n    ", out[i], i + 1 < outlen ? "," : "");
+    }
+    printf("\n};\n\n");
+    printf("static const regdump_t regdump = { regdump_data, REGDUMP_BYTES, %u };\n\n", dump.songticks);
+    printf("#endif /* __REGDUMP_H */\n");
+
+    fprintf(stderr, "%u ticks (%.1f s), %u bytes, %.2f bytes/tick, worst %u (bound %u)\n",
+            ticks, ticks / (double)TICKS_PER_SEC, outlen, outlen / (double)ticks, worst, REGDUMP_MAX_TICK);
+    fprintf(stderr, "  host sequencer %.0f ns/tick, replay %.0f ns/tick\n", ns, replayns);
+    free(out);
+
+    return 0;
+}
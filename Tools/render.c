@@ -0,0 +1,628 @@
+/**
+  ******************************************************************************
+  * @file           : render.c
+  * @brief          : Renders the song offline to a WAV file or prerender.h
+  ******************************************************************************
+  *
+  * Usage: render [-f song] [-s seconds] [-p order[:row]] [-r state]
+  *               [-w seconds:state] [-o out.wav] [-c prerender.h]
+  *        render -v song...
+  *        render -b dir [-j threads] [-t] [-s seconds] song...
+  *
+  * Runs the engine exactly as the firmware does - Chiptune_Process() polled
+  * before each Chiptune_AudioCallback() 8 kHz frame - until the song
+  * ends (plus a second of release tail) or for the given length. The song
+  * is the built-in one, or with -f a song container, mapped and played in
+  * place through Chiptune_PlaySong(), or a track.h-format header. -p starts
+  * at an order position through the seek index, reporting what building
+  * the index and seeking cost. -r resumes from a Chiptune_SaveState() blob,
+  * from a device or a previous -w, which saves one after the given time.
+  *
+  * -o writes a 16-bit stereo WAV. -c writes the header played by a
+  * CHIPTUNE_PRERENDERED build: the song as ADPCM blocks, mono when both
+  * channels are identical throughout. The report on stderr compares its
+  * flash cost and decode time with running the synth live; the flash is
+  * CHIPTUNE_FLASH_SIZE, less in a render built with CHIPTUNE_UPLOAD.
+  *
+  * -v checks many songs: each is mapped, must be accepted by the engine and
+  * is played to its end by the sequencer alone. Failures are listed, then
+  * a summary with the host time per song.
+  *
+  * -b renders many songs to dir/<song>.wav on a pool of threads (one per
+  * core, or -j), each running its own engine: the engine state is thread
+  * local on the host. -t adds a stem per channel, <song>.ch1.wav to .ch4,
+  * rendered as separate jobs with the other channels muted. Every job
+  * starts from Chiptune_Init(), so the files are the same whatever the
+  * thread count. The report gives the aggregate audio
+  * rendered per wall-clock second.
+  *
+  */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chiptune.h"
+#include "adpcm.h"
+#include "songfile.h"
+#if CHIPTUNE_REPLAY
+#include "regdump.h"
+#endif
+
+#define SAMPLE_RATE     8000
+#define TAIL_FRAMES     SAMPLE_RATE
+#define MAX_SECONDS     3600
+#define TICKS_PER_SEC   (CHIPTUNE_TEMPO * 2 / 5)
+#define CHUNK_FRAMES    4096
+#define STEM_MIX        (-1)
+
+/* Song from -f, data NULL for the built-in song */
+static songmap_t song;
+
+/* Batch rendering (-b): a job renders a song or one channel stem of it */
+typedef struct {
+    const char *path;
+    int stem;                 /* channel, or STEM_MIX */
+    uint32_t frames;
+    int failed;
+} job_t;
+
+static job_t *jobs;
+static int jobcount;
+static atomic_int nextjob;
+static const char *outdir;
+static uint32_t batchframes;
+
+/* Where rendering starts, and when to save the state */
+static int startorder = -1;
+static unsigned startrow;
+static const char *resumepath;
+static const char *savepath;
+static uint32_t saveframe;
+
+static double elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+/* Starts the song at order:row through the seek index */
+static int seek(unsigned order, unsigned row)
+{
+    struct timespec t0, t1, t2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Chiptune_BuildSeekIndex();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if(Chiptune_Seek(order, row) != HAL_OK)
+    {
+        fprintf(stderr, "render: cannot seek to %u:%u\n", order, row);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    fprintf(stderr, "seek index built in %.0f us, seek to %u:%u took %.1f us\n",
+            elapsed(&t0, &t1) / 1e3, order, row, elapsed(&t1, &t2) / 1e3);
+
+    return 0;
+}
+
+static int loadstate(const char *path)
+{
+    uint8_t blob[CHIPTUNE_STATE_MAX];
+    FILE *f = fopen(path, "rb");
+    size_t len;
+
+    if(!f)
+    {
+        perror(path);
+        return 1;
+    }
+    len = fread(blob, 1, sizeof(blob), f);
+    fclose(f);
+    if(Chiptune_LoadState(blob, len) != HAL_OK)
+    {
+        fprintf(stderr, "%s: not a state blob for this build\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int savestate(const char *path)
+{
+    uint8_t blob[CHIPTUNE_STATE_MAX];
+    uint32_t len;
+    FILE *f;
+
+    if(Chiptune_SaveState(blob, sizeof(blob), &len) != HAL_OK) return 1;
+    f = fopen(path, "wb");
+    if(!f || fwrite(blob, 1, len, f) != len)
+    {
+        perror(path);
+        if(f) fclose(f);
+        return 1;
+    }
+    fprintf(stderr, "saved %u byte state after %u frames to %s\n", len, saveframe, path);
+
+    return fclose(f) ? 1 : 0;
+}
+
+/* Renders up to max frames into lr (interleaved L/R), returns the count */
+static uint32_t rendersong(int16_t *lr, uint32_t max)
+{
+    const uint16_t *buf;
+    uint32_t n, tail = 0;
+
+    Chiptune_Init();
+#if CHIPTUNE_REPLAY
+    Chiptune_PlayDump(&regdump);
+#endif
+    if(song.data && Chiptune_PlaySong(song.data, song.len) != HAL_OK)
+    {
+        fprintf(stderr, "render: engine rejected the song\n");
+        return 0;
+    }
+    if(startorder >= 0 && seek(startorder, startrow)) return 0;
+    if(resumepath && loadstate(resumepath)) return 0;
+    buf = getAudioBuffer();
+
+    for(n = 0; n < max && tail < TAIL_FRAMES; n++)
+    {
+        uint32_t idx = (n * 2) % AUDIO_BUFFER_SIZE;
+
+        if(savepath && n == saveframe && savestate(savepath)) return 0;
+
+        Chiptune_Process();
+        Chiptune_AudioCallback();
+        lr[2 * n] = (int16_t)(buf[idx] ^ 0x8000);
+        lr[2 * n + 1] = (int16_t)(buf[idx + 1] ^ 0x8000);
+        if(!Chiptune_IsPlaying()) tail++;
+    }
+    if(savepath && n == saveframe && savestate(savepath)) return 0;
+
+    return n;
+}
+
+/* Maps, loads and plays each song to its end, returns the number that failed */
+static int validate(int count, char **paths)
+{
+    struct timespec t0, t1;
+    uint64_t bytes = 0, ticks = 0;
+    int failed = 0, i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(i = 0; i < count; i++)
+    {
+        songmap_t map;
+        uint32_t n = 0;
+
+        if(songfile_map(paths[i], &map))
+        {
+            failed++;
+            continue;
+        }
+        bytes += map.len;
+
+        Chiptune_Init();
+        if(Chiptune_PlaySong(map.data, map.len) != HAL_OK)
+        {
+            fprintf(stderr, "%s: rejected by the engine\n", paths[i]);
+            failed++;
+            songfile_unmap(&map);
+            continue;
+        }
+        do
+        {
+            Chiptune_Tick();
+            n++;
+        }
+        while(Chiptune_IsPlaying() && n < MAX_SECONDS * TICKS_PER_SEC);
+        if(Chiptune_IsPlaying())
+        {
+            fprintf(stderr, "%s: still playing after %d s\n", paths[i], MAX_SECONDS);
+            failed++;
+        }
+        ticks += n;
+        songfile_unmap(&map);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    fprintf(stderr, "%d songs, %d failed, %.1f KB mapped, %.1f min of music, host %.0f us per song\n",
+            count, failed, bytes / 1024.0, ticks / (60.0 * TICKS_PER_SEC), elapsed(&t0, &t1) / 1000 / count);
+
+    return failed;
+}
+
+static void wr16(FILE *f, uint16_t v)
+{
+    fputc(v & 0xff, f);
+    fputc(v >> 8, f);
+}
+
+static void wr32(FILE *f, uint32_t v)
+{
+    wr16(f, v & 0xffff);
+    wr16(f, v >> 16);
+}
+
+static void wavheader(FILE *f, uint32_t frames)
+{
+    fwrite("RIFF", 1, 4, f);
+    wr32(f, 36 + frames * 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wr32(f, 16);
+    wr16(f, 1);                 /* PCM */
+    wr16(f, 2);
+    wr32(f, SAMPLE_RATE);
+    wr32(f, SAMPLE_RATE * 4);
+    wr16(f, 4);
+    wr16(f, 16);
+    fwrite("data", 1, 4, f);
+    wr32(f, frames * 4);
+}
+
+static int writewav(const char *path, const int16_t *lr, uint32_t frames)
+{
+    FILE *f = fopen(path, "wb");
+    uint32_t i;
+
+    if(!f)
+    {
+        perror(path);
+        return 1;
+    }
+    wavheader(f, frames);
+    for(i = 0; i < frames * 2; i++) wr16(f, (uint16_t)lr[i]);
+
+    return fclose(f) ? 1 : 0;
+}
+
+/* dir/<song name without extension>[.chN].wav */
+static void jobpath(const job_t *job, char *out, size_t size)
+{
+    const char *name = strrchr(job->path, '/');
+    const char *ext;
+    int len;
+
+    name = name ? name + 1 : job->path;
+    ext = strrchr(name, '.');
+    len = ext && ext != name ? (int)(ext - name) : (int)strlen(name);
+    if(job->stem == STEM_MIX) snprintf(out, size, "%s/%.*s.wav", outdir, len, name);
+    else snprintf(out, size, "%s/%.*s.ch%d.wav", outdir, len, name, job->stem + 1);
+}
+
+/* Renders a job on this thread's engine, streaming the WAV; 0 when done */
+static int renderjob(job_t *job)
+{
+    int16_t lr[2 * CHUNK_FRAMES];
+    const uint16_t *buf;
+    uint32_t n = 0, tail = 0;
+    songmap_t map;
+    char path[4096];
+    FILE *f;
+    int err;
+
+    if(songfile_map(job->path, &map)) return 1;
+    Chiptune_Init();
+    if(Chiptune_PlaySong(map.data, map.len) != HAL_OK)
+    {
+        fprintf(stderr, "%s: rejected by the engine\n", job->path);
+        songfile_unmap(&map);
+        return 1;
+    }
+    if(job->stem != STEM_MIX)
+    {
+        chiptune_event_t solo = { 0, CHIPTUNE_EV_MUTE, 0, 0xf & ~(1 << job->stem), 0 };
+
+        Chiptune_PostEvent(&solo);
+    }
+    jobpath(job, path, sizeof(path));
+    f = fopen(path, "wb");
+    if(!f)
+    {
+        perror(path);
+        songfile_unmap(&map);
+        return 1;
+    }
+    wavheader(f, 0);
+    buf = getAudioBuffer();
+
+    while(n < batchframes && tail < TAIL_FRAMES)
+    {
+        uint32_t k;
+
+        for(k = 0; k < CHUNK_FRAMES && n < batchframes && tail < TAIL_FRAMES; k++, n++)
+        {
+            uint32_t idx = (n * 2) % AUDIO_BUFFER_SIZE;
+
+            Chiptune_Process();
+            Chiptune_AudioCallback();
+            lr[2 * k] = (int16_t)(buf[idx] ^ 0x8000);
+            lr[2 * k + 1] = (int16_t)(buf[idx + 1] ^ 0x8000);
+            if(!Chiptune_IsPlaying()) tail++;
+        }
+        fwrite(lr, sizeof(int16_t), 2 * k, f);
+    }
+    songfile_unmap(&map);
+    job->frames = n;
+
+    /* Now the length is known */
+    fseek(f, 0, SEEK_SET);
+    wavheader(f, n);
+    err = ferror(f);
+    if(fclose(f) || err)
+    {
+        perror(path);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void *worker(void *arg)
+{
+    int i;
+
+    (void)arg;
+    while((i = atomic_fetch_add(&nextjob, 1)) < jobcount)
+    {
+        jobs[i].failed = renderjob(&jobs[i]);
+    }
+
+    return NULL;
+}
+
+/* render -b: returns the number of jobs that failed */
+static int batch(int argc, char **argv)
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long seconds = MAX_SECONDS;
+    int stems = 0, opt = 1, failed = 0, i, s;
+    pthread_t *pool;
+    struct timespec t0, t1, c0, c1;
+    uint64_t frames = 0;
+    double wall;
+
+    while(opt < argc && argv[opt][0] == '-')
+    {
+        if(!strcmp(argv[opt], "-b") && opt + 1 < argc) outdir = argv[++opt];
+        else if(!strcmp(argv[opt], "-j") && opt + 1 < argc) threads = strtol(argv[++opt], NULL, 0);
+        else if(!strcmp(argv[opt], "-s") && opt + 1 < argc) seconds = strtoul(argv[++opt], NULL, 0);
+        else if(!strcmp(argv[opt], "-t")) stems = 1;
+        else break;
+        opt++;
+    }
+    if(!outdir || opt == argc || argv[opt][0] == '-' || threads < 1 || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: render -b dir [-j threads] [-t] [-s seconds] song...\n");
+        return -1;
+    }
+    batchframes = seconds * SAMPLE_RATE;
+
+    jobcount = (argc - opt) * (stems ? 1 + CHIPTUNE_CHANNELS : 1);
+    jobs = calloc(jobcount, sizeof(job_t));
+    for(i = opt, jobcount = 0; i < argc; i++)
+    {
+        for(s = STEM_MIX; s < (stems ? CHIPTUNE_CHANNELS : 0); s++)
+        {
+            jobs[jobcount].path = argv[i];
+            jobs[jobcount++].stem = s;
+        }
+    }
+    if(threads > jobcount) threads = jobcount;
+    pool = malloc(threads * sizeof(pthread_t));
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &c0);
+    for(i = 0; i < threads; i++) pthread_create(&pool[i], NULL, worker, NULL);
+    for(i = 0; i < threads; i++) pthread_join(pool[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &c1);
+    wall = elapsed(&t0, &t1) / 1e9;
+
+    for(i = 0; i < jobcount; i++)
+    {
+        failed += jobs[i].failed;
+        frames += jobs[i].frames;
+    }
+    fprintf(stderr, "%d songs, %d files (%d failed) on %ld threads: %.1f min of audio in %.2f s, %.0fx real time\n",
+            argc - opt, jobcount, failed, threads, frames / (60.0 * SAMPLE_RATE), wall,
+            frames / (double)SAMPLE_RATE / wall);
+    fprintf(stderr, "  %.2f Mframes/s aggregate, %.1f ns of CPU per frame\n",
+            frames / wall / 1e6, elapsed(&c0, &c1) / frames);
+    free(pool);
+    free(jobs);
+
+    return failed;
+}
+
+/* Encodes the song as prerender.h, returns the ADPCM size or 0 on error */
+static uint32_t writeheader(const char *path, const int16_t *lr, uint32_t frames, double *decodens)
+{
+    uint32_t blocks = (frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+    uint32_t channels = 1, size, i, c;
+    int16_t pcm[ADPCM_BLOCK_FRAMES];
+    struct timespec t0, t1;
+    uint8_t *data;
+    FILE *f;
+
+    for(i = 0; i < frames; i++)
+    {
+        if(lr[2 * i] != lr[2 * i + 1])
+        {
+            channels = 2;
+            break;
+        }
+    }
+
+    size = blocks * channels * ADPCM_BLOCK_BYTES;
+    data = malloc(size);
+    for(i = 0; i < blocks; i++)
+    {
+        uint32_t first = i * ADPCM_BLOCK_FRAMES;
+        uint32_t n = frames - first < ADPCM_BLOCK_FRAMES ? frames - first : ADPCM_BLOCK_FRAMES;
+
+        for(c = 0; c < channels; c++)
+        {
+            uint32_t k;
+
+            for(k = 0; k < n; k++) pcm[k] = lr[2 * (first + k) + c];
+            ADPCM_EncodeBlock(pcm, n, data + (i * channels + c) * ADPCM_BLOCK_BYTES);
+        }
+    }
+
+    /* What Chiptune_FillBuffer() spends per frame */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(i = 0; i < blocks * channels; i++)
+    {
+        ADPCM_DecodeBlock(data + i * ADPCM_BLOCK_BYTES, pcm);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *decodens = elapsed(&t0, &t1) / ((double)blocks * ADPCM_BLOCK_FRAMES);
+
+    f = fopen(path, "w");
+    if(!f)
+    {
+        perror(path);
+        free(data);
+        return 0;
+    }
+    fprintf(f, "/**\n");
+    fprintf(f, "  ******************************************************************************\n");
+    fprintf(f, "  * @file           : prerender.h\n");
+    fprintf(f, "  * @brief          : Song rendered offline for CHIPTUNE_PRERENDERED builds\n");
+    fprintf(f, "  ******************************************************************************\n");
+    fprintf(f, "  *\n");
+    fprintf(f, "  * Generated by Tools/render - do not edit, run 'make -C Tools prerender'.\n");
+    fprintf(f, "  *\n");
+    fprintf(f, "  */\n\n");
+    fprintf(f, "#ifndef __PRERENDER_H\n");
+    fprintf(f, "#define __PRERENDER_H\n\n");
+    fprintf(f, "#include <stdint.h>\n\n");
+    fprintf(f, "#define PRERENDER_FRAMES        %u\n", frames);
+    fprintf(f, "#define PRERENDER_BLOCKS        %u\n", blocks);
+    fprintf(f, "#define PRERENDER_CHANNELS      %u\n\n", channels);
+    fprintf(f, "/* ADPCM blocks, left then right block per step when stereo */\n");
+    fprintf(f, "static const uint8_t prerender_data[%u] = {", size);
+    for(i = 0; i < size; i++)
+    {
+        fprintf(f, "%s0x%02x%s", i % 12 ? " " : "\n    ", data[i], i + 1 < size ? "," : "");
+    }
+    fprintf(f, "\n};\n\n");
+    fprintf(f, "#endif /* __PRERENDER_H */\n");
+    free(data);
+
+    return fclose(f) ? 0 : size;
+}
+
+int main(int argc, char **argv)
+{
+    const char *songpath = NULL, *wavpath = NULL, *hpath = NULL;
+    unsigned long seconds = MAX_SECONDS, saveseconds;
+    uint32_t frames, max;
+    struct timespec t0, t1;
+    double synthns;
+    int16_t *lr;
+    int opt = 1;
+
+    if(argc > 2 && !strcmp(argv[1], "-v")) return validate(argc - 2, argv + 2) ? 1 : 0;
+    if(argc > 1 && !strcmp(argv[1], "-b"))
+    {
+        int failed = batch(argc, argv);
+
+        return failed < 0 ? 2 : failed ? 1 : 0;
+    }
+
+    while(opt < argc)
+    {
+        if(!strcmp(argv[opt], "-f") && opt + 1 < argc)
+        {
+            songpath = argv[++opt];
+        }
+        else if(!strcmp(argv[opt], "-s") && opt + 1 < argc)
+        {
+            seconds = strtoul(argv[++opt], NULL, 0);
+        }
+        else if(!strcmp(argv[opt], "-p") && opt + 1 < argc)
+        {
+            if(sscanf(argv[++opt], "%d:%u", &startorder, &startrow) < 1 || startorder < 0) break;
+        }
+        else if(!strcmp(argv[opt], "-r") && opt + 1 < argc)
+        {
+            resumepath = argv[++opt];
+        }
+        else if(!strcmp(argv[opt], "-w") && opt + 1 < argc)
+        {
+            char *end;
+
+            saveseconds = strtoul(argv[++opt], &end, 0);
+            if(*end != ':' || !end[1]) break;
+            saveframe = saveseconds * SAMPLE_RATE;
+            savepath = end + 1;
+        }
+        else if(!strcmp(argv[opt], "-o") && opt + 1 < argc)
+        {
+            wavpath = argv[++opt];
+        }
+        else if(!strcmp(argv[opt], "-c") && opt + 1 < argc)
+        {
+            hpath = argv[++opt];
+        }
+        else break;
+        opt++;
+    }
+    if(opt != argc || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: render [-f song] [-s seconds] [-p order[:row]] [-r state]\n"
+                        "              [-w seconds:state] [-o out.wav] [-c prerender.h]\n"
+                        "       render -v song...\n"
+                        "       render -b dir [-j threads] [-t] [-s seconds] song...\n");
+        return 2;
+    }
+    if(songpath && songfile_map(songpath, &song)) return 1;
+
+    max = seconds * SAMPLE_RATE;
+    lr = malloc(max * 2 * sizeof(int16_t));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    frames = rendersong(lr, max);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if(!frames)
+    {
+        free(lr);
+        return 1;
+    }
+    synthns = elapsed(&t0, &t1) / frames;
+
+    fprintf(stderr, "rendered %.1f s (%u frames)%s, host synth %.1f ns/frame\n",
+            frames / (double)SAMPLE_RATE, frames, Chiptune_IsPlaying() ? ", cut off" : "", synthns);
+    if(song.data) songfile_unmap(&song);
+
+    if(wavpath && writewav(wavpath, lr, frames))
+    {
+        free(lr);
+        return 1;
+    }
+
+    if(hpath)
+    {
+        double decodens;
+        uint32_t size = writeheader(hpath, lr, frames, &decodens);
+
+        if(!size)
+        {
+            free(lr);
+            return 1;
+        }
+        fprintf(stderr, "prerendered: %u bytes ADPCM (%u bytes PCM16 stereo, %.0f%% of the %u KB "
+                "firmware flash)\n", size, frames * 4, 100.0 * size / CHIPTUNE_FLASH_SIZE,
+                CHIPTUNE_FLASH_SIZE / 1024);
+        fprintf(stderr, "  host decode %.1f ns/frame vs synth %.1f ns/frame (%.1fx less CPU)\n",
+                decodens, synthns, synthns / decodens);
+    }
+    free(lr);
+
+    return 0;
+}
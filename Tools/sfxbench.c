@@ -0,0 +1,210 @@
+/**
+  ******************************************************************************
+  * @file           : sfxbench.c
+  * @brief          : Measures sound effects played over the music
+  ******************************************************************************
+  *
+  * Usage: sfxbench [-s seconds]
+  *
+  * Plays the built-in song and fires the effects below through
+  * CHIPTUNE_EV_SFX at pseudo-random times, each stamped with the time it
+  * is posted. Reports the trigger latency (post to the tick that starts
+  * the effect, the firmware equivalent is Chiptune_GetStats() sfxlatency)
+  * and the host cost of the audio callback and of the sequencer tick with
+  * and without effects playing. Then checks the priority rules: a full
+  * set of borrowed channels refuses a lower priority effect and gives the
+  * lowest one up to a higher priority effect.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chiptune.h"
+
+#define TICK_FRAMES     (CHIPTUNE_SAMPLE_RATE * 5 / 2 / CHIPTUNE_TEMPO)
+#define MAX_SECONDS     3600
+
+/* Command numbers in CHIPTUNE_COMMANDS */
+enum { C_STOP, C_DUTY, C_FADE, C_INERTIA, C_JUMP, C_SLIDE, C_DUTYSLIDE, C_WAIT,
+       C_VOLUME, C_WAVE, C_VIBRATO, C_NOTE_REL, C_NOTE_ABS, C_PAN, C_TABLE, C_SAMPLE };
+
+/* UI beep: short pulse */
+static const uint8_t beep[] = {
+    C_WAVE, WF_PUL, C_VOLUME, 0xc0, C_WAIT, 6, C_VOLUME, 0x00
+};
+
+/* Coin: two notes an octave apart, fading out */
+static const uint8_t coin[] = {
+    C_WAVE, WF_PUL, C_VOLUME, 0xb0, C_WAIT, 3, C_NOTE_REL, 0x3c, C_FADE, 0xf0, C_WAIT, 12
+};
+
+/* Alarm: alternates two notes until a higher priority effect takes it */
+static const uint8_t alarm[] = {
+    C_WAVE, WF_SAW, C_VOLUME, 0xa0, C_WAIT, 4, C_NOTE_REL, 0x3c, C_WAIT, 4, C_NOTE_REL, 0x30,
+    C_JUMP, 2
+};
+
+static const chiptune_sfx_t bank[] = {
+    { beep, sizeof(beep) / 2, 0xf },
+    { coin, sizeof(coin) / 2, 0xc },
+    { alarm, sizeof(alarm) / 2, 0xf },
+};
+
+#define SFX_BEEP        0
+#define SFX_COIN        1
+#define SFX_ALARM       2
+#define SFX_RANDOM      2   /* the effects fired at random, the alarm never ends */
+
+static double elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+static void post(uint8_t fx, uint8_t priority)
+{
+    chiptune_event_t e = { Chiptune_GetTime(), CHIPTUNE_EV_SFX, priority, fx, 0x30 };
+
+    if(Chiptune_PostEvent(&e) != HAL_OK)
+    {
+        fprintf(stderr, "sfxbench: event queue full\n");
+        exit(1);
+    }
+}
+
+/* One frame of main loop and audio interrupt; adds the host ns of each */
+static void step(double *tick, double *mix)
+{
+    struct timespec t0, t1, t2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Chiptune_Process();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    Chiptune_AudioCallback();
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    *tick += elapsed(&t0, &t1);
+    *mix += elapsed(&t1, &t2);
+}
+
+/* Fires effects one at a time through the song, reports latency and cost */
+static int measure(uint32_t frames)
+{
+    double tickns[2] = { 0 }, mixns[2] = { 0 };
+    uint32_t ticks[2] = { 0 }, mixes[2] = { 0 };
+    uint32_t n, seed = 1, next = 0, posted = 0, triggers = 0, latency = 0, worst = 0;
+    chiptune_stats_t stats;
+
+    Chiptune_Init();
+    Chiptune_SetSfxBank(bank, sizeof(bank) / sizeof(bank[0]));
+
+    for(n = 0; n < frames; n++)
+    {
+        double t = 0, m = 0;
+        uint8_t busy = Chiptune_GetSfxChannels() != 0;
+
+        if(!busy && !posted && n >= next)
+        {
+            seed = seed * 1103515245 + 12345;
+            post((seed >> 16) % SFX_RANDOM, 1);
+            posted = n + 1;
+        }
+        step(&t, &m);
+        if(n && n % TICK_FRAMES == 0)
+        {
+            tickns[busy] += t;
+            ticks[busy]++;
+        }
+        mixns[busy] += m;
+        mixes[busy]++;
+
+        if(posted && Chiptune_GetSfxChannels())
+        {
+            /* Started by the tick in this frame */
+            uint32_t late = n + 1 - posted;
+
+            latency += late;
+            if(late > worst) worst = late;
+            triggers++;
+            posted = 0;
+            seed = seed * 1103515245 + 12345;
+            next = n + (seed >> 16) % CHIPTUNE_SAMPLE_RATE;
+        }
+    }
+
+    Chiptune_GetStats(&stats);
+    if(!triggers || !ticks[0] || !ticks[1])
+    {
+        fprintf(stderr, "sfxbench: too short to measure\n");
+        return 1;
+    }
+    fprintf(stderr, "%u effects: trigger latency %.2f ms average, %.2f ms worst (engine %u samples; tick %.1f ms)\n",
+            triggers, latency * 1000.0 / triggers / CHIPTUNE_SAMPLE_RATE, worst * 1000.0 / CHIPTUNE_SAMPLE_RATE,
+            stats.sfxlatency, TICK_FRAMES * 1000.0 / CHIPTUNE_SAMPLE_RATE);
+    fprintf(stderr, "  audio callback %.1f ns with effects, %.1f ns without (host)\n",
+            mixns[1] / mixes[1], mixns[0] / mixes[0]);
+    fprintf(stderr, "  tick %.0f ns with effects, %.0f ns without (host)\n",
+            tickns[1] / ticks[1], tickns[0] / ticks[0]);
+
+    return 0;
+}
+
+/* Runs frames until the next tick has been applied (the first is at
+ * TICK_FRAMES) */
+static void totick(void)
+{
+    double t = 0, m = 0;
+
+    do step(&t, &m);
+    while(Chiptune_GetTime() % TICK_FRAMES != 1 || Chiptune_GetTime() == 1);
+}
+
+/* Fills the channels with alarms, then checks who gets a channel */
+static int priorities(void)
+{
+    chiptune_stats_t stats;
+    int failed = 0;
+    uint8_t i;
+
+    Chiptune_Init();
+    Chiptune_SetSfxBank(bank, sizeof(bank) / sizeof(bank[0]));
+    for(i = 0; i < CHIPTUNE_CHANNELS; i++) post(SFX_ALARM, 2);
+    totick();
+    if(Chiptune_GetSfxChannels() != 0xf) failed |= 1;
+
+    post(SFX_BEEP, 1);
+    totick();
+    Chiptune_GetStats(&stats);
+    if(stats.sfxdropped != 1) failed |= 2;
+
+    /* Takes an alarm's channel, then hands it back to the music */
+    post(SFX_BEEP, 3);
+    totick();
+    while(Chiptune_GetSfxChannels() == 0xf) totick();
+    Chiptune_GetStats(&stats);
+    if(stats.sfxdropped != 1 || Chiptune_GetSfxChannels() == 0) failed |= 4;
+
+    fprintf(stderr, "priorities: %s\n", failed ? "FAILED" : "lower refused, higher takes the lowest, channel handed back");
+
+    return failed != 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long seconds = 120;
+
+    if(argc == 3 && !strcmp(argv[1], "-s"))
+    {
+        seconds = strtoul(argv[2], NULL, 0);
+    }
+    if((argc != 1 && argc != 3) || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: sfxbench [-s seconds]\n");
+        return 2;
+    }
+
+    if(measure(seconds * CHIPTUNE_SAMPLE_RATE)) return 1;
+
+    return priorities();
+}
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file           : songbank.c
+  * @brief          : Packs songs into a song bank header, measures switching
+  ******************************************************************************
+  *
+  * Usage: songbank song... > songbank.h
+  *
+  * Each input is a song container or a song header in the format of
+  * Core/Inc/track.h, converted to a container. The output defines
+  * songbank[], the directory and songs in the Chiptune_SetSongBank()
+  * format.
+  *
+  * On stderr it reports the bank layout, then plays the bank through the
+  * engine switching songs at pseudo-random times and reports the switch
+  * latency (request to the new song's first row) and the cost of the
+  * switching tick. The firmware equivalent is Chiptune_GetStats() song.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+
+#define MAX_SONGS       32
+#define BANK_MAX        (1024 * 1024)
+#define SWITCHES        1000
+#define FRAMES_PER_MS   (CHIPTUNE_SAMPLE_RATE / 1000)
+#define TICK_FRAMES     (CHIPTUNE_SAMPLE_RATE * 5 / 2 / CHIPTUNE_TEMPO)
+
+static uint8_t bank[BANK_MAX];
+
+/* Appends the song at 'pos', returns its length or 0 on error */
+static uint32_t loadsong(const char *path, uint32_t pos)
+{
+    uint32_t len;
+    uint8_t *song = songfile_load(path, &len);
+
+    if(!song) return 0;
+    if(pos + len > BANK_MAX)
+    {
+        fprintf(stderr, "%s: the bank is over %u KB\n", path, BANK_MAX / 1024);
+        free(song);
+        return 0;
+    }
+    memcpy(&bank[pos], song, len);
+    free(song);
+
+    return len;
+}
+
+static double elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+/* One frame of main loop and audio interrupt, returns the host ns
+ * Chiptune_Process took */
+static double step(void)
+{
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Chiptune_Process();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    Chiptune_AudioCallback();
+
+    return elapsed(&t0, &t1);
+}
+
+/*
+ * Plays the bank, switching songs at pseudo-random times, and reports the
+ * latency and cost. At the startup tempo sequencer ticks fall on the
+ * multiples of TICK_FRAMES, counted from Chiptune_Init().
+ */
+static int measure(uint32_t size, uint8_t count)
+{
+    uint32_t i, latency = 0, worst = 0, seed = 1, ticks = 0, missed = 0, now;
+    double cost = 0, worstcost = 0, tickcost = 0;
+
+    Chiptune_Init();
+    if(Chiptune_SetSongBank(bank, size) != HAL_OK)
+    {
+        fprintf(stderr, "songbank: engine rejected the bank\n");
+        return 1;
+    }
+
+    for(i = 0; i < SWITCHES; i++)
+    {
+        uint8_t target = (Chiptune_GetSong() + 1) % count;
+        uint32_t wait, requested;
+        double ns;
+
+        /* Play on for up to 2 s */
+        seed = seed * 1103515245 + 12345;
+        for(wait = (seed >> 16) % (2 * CHIPTUNE_SAMPLE_RATE); wait; wait--)
+        {
+            now = Chiptune_GetTime();
+            ns = step();
+            if(now && now % TICK_FRAMES == 0)
+            {
+                tickcost += ns;
+                ticks++;
+            }
+        }
+
+        requested = Chiptune_GetTime();
+        Chiptune_SelectSong(target);
+        do
+        {
+            now = Chiptune_GetTime();
+            ns = step();
+        }
+        while(!now || now % TICK_FRAMES);
+        if(Chiptune_GetSong() != target) missed++;
+
+        latency += now - requested;
+        if(now - requested > worst) worst = now - requested;
+        cost += ns;
+        if(ns > worstcost) worstcost = ns;
+    }
+
+    fprintf(stderr, "%d switches: latency %.1f ms average, %.1f ms worst (tick period %.1f ms)\n",
+            SWITCHES, latency / (double)SWITCHES / FRAMES_PER_MS, worst / (double)FRAMES_PER_MS,
+            TICK_FRAMES / (double)FRAMES_PER_MS);
+    fprintf(stderr, "  switching tick %.0f ns average, %.0f ns worst; plain tick %.0f ns (host)\n",
+            cost / SWITCHES, worstcost, tickcost / ticks);
+    if(missed && count > 1)
+    {
+        fprintf(stderr, "songbank: %u switches did not take effect on the next tick\n", missed);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t offset[MAX_SONGS], length[MAX_SONGS];
+    uint32_t pos, i;
+    int count = argc - 1;
+
+    if(count < 1 || count > MAX_SONGS)
+    {
+        fprintf(stderr, "usage: songbank song... > songbank.h (up to %d songs)\n", MAX_SONGS);
+        return 2;
+    }
+
+    pos = SONGBANK_HEADER + count * SONGBANK_ENTRY;
+    for(i = 0; i < (uint32_t)count; i++)
+    {
+        length[i] = loadsong(argv[i + 1], pos);
+        if(!length[i]) return 1;
+        offset[i] = pos;
+        pos += length[i];
+    }
+
+    bank[0] = 'S';
+    bank[1] = 'B';
+    bank[2] = SONGBANK_VERSION;
+    bank[3] = count;
+    for(i = 0; i < (uint32_t)count; i++)
+    {
+        uint8_t *e = &bank[SONGBANK_HEADER + i * SONGBANK_ENTRY];
+        const uint8_t *song = &bank[offset[i]];
+        uint8_t b;
+
+        for(b = 0; b < 4; b++)
+        {
+            e[b] = (uint8_t)(offset[i] >> (8 * b));
+            e[4 + b] = (uint8_t)(length[i] >> (8 * b));
+        }
+        fprintf(stderr, "song %u: %s, %u bytes at 0x%05x, %u orders, %u tracks, %u-bit offsets\n",
+                i, argv[i + 1], length[i], offset[i], song[6], song[5], 8 * song[3]);
+    }
+    fprintf(stderr, "bank: %u songs, %u bytes\n", count, pos);
+
+    printf("/**\n");
+    printf("  ******************************************************************************\n");
+    printf("  * @file           : songbank.h\n");
+    printf("  * @brief          : Song bank for CHIPTUNE_SONGBANK builds\n");
+    printf("  ******************************************************************************\n");
+    printf("  *\n");
+    printf("  * Generated by Tools/songbank - do not edit, run 'make -C Tools songbank'.\n");
+    printf("  *\n");
+    printf("  */\n\n");
+    printf("#ifndef __SONGBANK_H\n");
+    printf("#define __SONGBANK_H\n\n");
+    printf("#include <stdint.h>\n\n");
+    printf("#define SONGBANK_SONGS          %d\n\n", count);
+    printf("static const uint8_t songbank[%u] = {", pos);
+    for(i = 0; i < pos; i++)
+    {
+        printf("%s0x%02x%s", i % 12 ? " " : "\n    ", bank[i], i + 1 < pos ? "," : "");
+    }
+    printf("\n};\n\n");
+    printf("#endif /* __SONGBANK_H */\n");
+
+    return measure(pos, count);
+}
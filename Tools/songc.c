@@ -0,0 +1,737 @@
+/**
+  ******************************************************************************
+  * @file           : songc.c
+  * @brief          : Compiles tracker text into packed song data
+  ******************************************************************************
+  *
+  * Usage: songc [-h track.h] [-o song.sg] song.txt
+  *        songc -d song > song.txt
+  *
+  * The source is line based, ';' starts a comment and numbers are hex:
+  *
+  *   song                  one order position per line: each channel's
+  *     01 02 03+2 --       track, optionally transposed by -8..+7
+  *   instrument 1          one line per instrument step: command and
+  *     w02                 parameter; a stop follows the last one
+  *     vff
+  *   track 01              rows 00-1f: note, instrument, command and
+  *     00 C-4 1 v80        parameter; rows not listed are empty
+  *     08 D#4 . ...
+  *
+  * Notes are C-0 to G-a ('---' none), commands are the letters of
+  * CHIPTUNE_COMMANDS ('...' none). Tracks are 01-3f, instruments 1-f. On
+  * a track row 't' sets the speed in ticks per row, 4.4 fixed point: t48
+  * plays rows of 4 and 5 ticks in turn. Only containers play it so, a
+  * track.h header has it delay the instrument, so -h refuses it. The filter commands 'c' and 'q'
+  * are past the 4 bits of a row's command and only go in instruments.
+  *
+  * -h writes the header the firmware builds in (the format of
+  * Core/Inc/track.h, 13-bit offsets, at most 8 KB); -o writes a version 3
+  * song container for Chiptune_PlaySong() or Tools/songbank. Identical
+  * tracks are packed once, and a track that is a transposed copy of
+  * another plays that one through the order list's transposition where it
+  * fits. Track numbers stay as in the source, the table entries of the
+  * shared ones are left pointing at the first. On stderr it reports the
+  * packed size of each part and the most instrument commands a tick runs;
+  * an instrument that can loop without a wait, or outruns
+  * CHIPTUNE_INSTR_BUDGET, is an error (see Tools/instrcheck).
+  *
+  * -d turns a song container or track.h-format header back into source.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+
+#define MAX_TRACKS      0x3f    /* 6-bit track numbers in the order list */
+#define INSTR_LINES     256     /* 8-bit 'j' targets */
+#define V1_MAX          0x2000  /* 13-bit offsets */
+#define DATA_MAX        (1024 * 1024)
+#define LINE_MAX        256
+#define EOL             "\r\n"  /* track.h keeps the CRLF line ends of Core/ */
+
+typedef struct {
+    uint8_t note;
+    uint8_t instr;
+    uint8_t cmd;
+    uint8_t param;
+} row_t;
+
+static const char commands[] = CHIPTUNE_COMMANDS;
+static const char *notenames[12] = {
+    "C-", "C#", "D-", "D#", "E-", "F-", "F#", "G-", "G#", "A-", "A#", "B-"
+};
+
+/* Source */
+static row_t track[MAX_TRACKS + 1][TRACKLEN];
+static uint8_t trackdef[MAX_TRACKS + 1];
+static uint8_t instr[SONG_MAX_INSTRUMENTS + 1][INSTR_LINES][2];
+static uint16_t instrlen[SONG_MAX_INSTRUMENTS + 1];
+static uint8_t instrdef[SONG_MAX_INSTRUMENTS + 1];
+static uint8_t order[SONG_MAX_ORDERS][CHIPTUNE_CHANNELS];
+static int8_t transp[SONG_MAX_ORDERS][CHIPTUNE_CHANNELS];
+static uint8_t orders;
+
+/* Packed tracks: the track each used one is played as, and transposed by */
+static uint8_t base[MAX_TRACKS + 1];
+static int8_t shift[MAX_TRACKS + 1];
+static uint8_t tracks;      /* highest packed track number */
+
+/* Resources, LSB first like the engine's readchunk() */
+static uint8_t data[DATA_MAX];
+static uint32_t bitpos;
+
+static void putbits(uint32_t v, uint8_t n)
+{
+    for(; n; n--, v >>= 1, bitpos++)
+    {
+        if(v & 1) data[bitpos / 8] |= 1 << (bitpos % 8);
+    }
+}
+
+static uint32_t align(void)
+{
+    bitpos = (bitpos + 7) & ~7u;
+
+    return bitpos / 8;
+}
+
+static uint32_t getbits(const uint8_t *d, uint32_t len, uint32_t *bit, uint8_t n)
+{
+    uint32_t v = 0;
+    uint8_t i;
+
+    for(i = 0; i < n; i++, (*bit)++)
+    {
+        uint8_t b = *bit / 8 < len ? d[*bit / 8] : 0;
+
+        v |= ((b >> (*bit % 8)) & 1u) << i;
+    }
+
+    return v;
+}
+
+static int hexdigit(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+    return -1;
+}
+
+/* Parses a hex number of up to 'max', returns -1 if it is not one */
+static long hexnum(const char *s, long max)
+{
+    char *end;
+    long v;
+
+    if(!s || hexdigit(*s) < 0) return -1;
+    v = strtol(s, &end, 16);
+
+    return (*end || v > max) ? -1 : v;
+}
+
+static int parsenote(const char *s, uint8_t *note)
+{
+    static const uint8_t semitone[7] = { 9, 11, 0, 2, 4, 5, 7 };
+    int oct, n;
+
+    if(!strcmp(s, "---"))
+    {
+        *note = 0;
+        return 0;
+    }
+    if(strlen(s) != 3 || s[0] < 'A' || s[0] > 'G' || (s[1] != '-' && s[1] != '#') ||
+       (oct = hexdigit(s[2])) < 0)
+    {
+        return -1;
+    }
+    n = 1 + 12 * oct + semitone[s[0] - 'A'] + (s[1] == '#');
+    if(n > 127) return -1;
+    *note = n;
+
+    return 0;
+}
+
+/* Command letter and two hex digits; 'none' accepts "..." */
+static int parsecmd(const char *s, uint8_t none, uint8_t *cmd, uint8_t *param)
+{
+    const char *c;
+    long p;
+
+    if(none && !strcmp(s, "..."))
+    {
+        *cmd = *param = 0;
+        return 0;
+    }
+    c = *s ? strchr(commands, *s) : NULL;
+    p = strlen(s) == 3 ? hexnum(s + 1, 0xff) : -1;
+    /* Rows pack the command in 4 bits */
+    if(!c || p < 0 || (none && (c == commands || c - commands > 15))) return -1;
+    *cmd = c - commands;
+    *param = p;
+
+    return 0;
+}
+
+/* Track reference of the order list: "--", or track[+-transposition] */
+static int parseref(char *s, uint8_t *t, int8_t *tr)
+{
+    char *sign = strpbrk(s, "+-");
+    long n, k = 0;
+
+    if(!strcmp(s, "--"))
+    {
+        *t = 0;
+        *tr = 0;
+        return 0;
+    }
+    if(sign)
+    {
+        if(sign[1] < '0' || sign[1] > '8' || sign[2]) return -1;
+        k = sign[1] - '0';
+        if(*sign == '-') k = -k;
+        *sign = 0;
+    }
+    n = hexnum(s, MAX_TRACKS);
+    if(n < 1 || k < -8 || k > 7) return -1;
+    *t = n;
+    *tr = k;
+
+    return 0;
+}
+
+static int parse(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char text[LINE_MAX], *tok[6];
+    enum { NONE, SONG, INSTR, TRACK } section = NONE;
+    unsigned line = 0, num = 0;
+
+    if(!f)
+    {
+        perror(path);
+        return 1;
+    }
+
+    while(fgets(text, sizeof(text), f))
+    {
+        char *comment = strchr(text, ';');
+        int n = 0;
+
+        line++;
+        if(comment) *comment = 0;
+        for(tok[0] = strtok(text, " \t\r\n"); tok[n] && n < 5; tok[n] = strtok(NULL, " \t\r\n")) n++;
+        if(!n) continue;
+        if(n > 4) goto error;
+
+        if(!strcmp(tok[0], "song") && n == 1)
+        {
+            section = SONG;
+            continue;
+        }
+        if((!strcmp(tok[0], "instrument") || !strcmp(tok[0], "track")) && n == 2)
+        {
+            long v = hexnum(tok[1], tok[0][0] == 'i' ? SONG_MAX_INSTRUMENTS : MAX_TRACKS);
+
+            section = tok[0][0] == 'i' ? INSTR : TRACK;
+            num = v;
+            if(v < 1 || (section == INSTR ? instrdef[num] : trackdef[num])) goto error;
+            if(section == INSTR) instrdef[num] = 1;
+            else trackdef[num] = 1;
+            continue;
+        }
+
+        if(section == SONG)
+        {
+            uint8_t ch;
+
+            if(n != CHIPTUNE_CHANNELS || orders == SONG_MAX_ORDERS) goto error;
+            for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+            {
+                if(parseref(tok[ch], &order[orders][ch], &transp[orders][ch])) goto error;
+            }
+            orders++;
+        }
+        else if(section == INSTR)
+        {
+            uint8_t *il = instr[num][instrlen[num]];
+
+            if(n != 1 || instrlen[num] == INSTR_LINES || parsecmd(tok[0], 0, &il[0], &il[1])) goto error;
+            instrlen[num]++;
+        }
+        else if(section == TRACK)
+        {
+            long r = hexnum(tok[0], TRACKLEN - 1);
+            row_t *row = &track[num][r < 0 ? 0 : r];
+            long i = -1;
+
+            if(r < 0 || n < 2 || parsenote(tok[1], &row->note)) goto error;
+            if(n > 2 && strcmp(tok[2], ".") && ((i = hexnum(tok[2], SONG_MAX_INSTRUMENTS)) < 1)) goto error;
+            row->instr = i < 0 ? 0 : i;
+            if(n > 3 && parsecmd(tok[3], 1, &row->cmd, &row->param)) goto error;
+        }
+        else goto error;
+    }
+    fclose(f);
+
+    if(!orders)
+    {
+        fprintf(stderr, "%s: no order positions\n", path);
+        return 1;
+    }
+
+    return 0;
+
+error:
+    fprintf(stderr, "%s:%u: syntax error\n", path, line);
+    fclose(f);
+
+    return 1;
+}
+
+/* Whether b is a with every note moved by the same *k semitones */
+static uint8_t transposed(const row_t *a, const row_t *b, int *k)
+{
+    uint8_t r, found = 0;
+
+    *k = 0;
+    for(r = 0; r < TRACKLEN; r++)
+    {
+        if(a[r].instr != b[r].instr || a[r].cmd != b[r].cmd || a[r].param != b[r].param ||
+           !a[r].note != !b[r].note)
+        {
+            return 0;
+        }
+        if(!a[r].note) continue;
+        if(!found)
+        {
+            *k = b[r].note - a[r].note;
+            found = 1;
+        }
+        else if(b[r].note - a[r].note != *k)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Whether every use of source track t still fits the 4-bit transposition moved by k */
+static uint8_t fits(uint8_t t, int k)
+{
+    uint8_t p, ch;
+
+    for(p = 0; p < orders; p++)
+    {
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            if(order[p][ch] == t && (transp[p][ch] + k < -8 || transp[p][ch] + k > 7)) return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Finds the track each used one is played as, in order of first use */
+static int assign(const char *path, unsigned *same, unsigned *moved)
+{
+    uint8_t p, ch, e;
+
+    for(p = 0; p < orders; p++)
+    {
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            uint8_t t = order[p][ch];
+            int k;
+
+            if(!t || base[t]) continue;
+            if(!trackdef[t])
+            {
+                fprintf(stderr, "%s: track %02x is used but not defined\n", path, t);
+                return 1;
+            }
+            for(e = 1; e <= MAX_TRACKS; e++)
+            {
+                if(base[e] == e && transposed(track[e], track[t], &k) && fits(t, k)) break;
+            }
+            if(e <= MAX_TRACKS)
+            {
+                if(k) (*moved)++;
+                else (*same)++;
+            }
+            else
+            {
+                e = t;
+                k = 0;
+                if(t > tracks) tracks = t;
+            }
+            base[t] = e;
+            shift[t] = k;
+        }
+    }
+
+    return 0;
+}
+
+static void putrow(const row_t *row)
+{
+    putbits((row->note != 0) | ((row->instr != 0) << 1) | ((row->cmd != 0) << 2), 3);
+    if(row->note) putbits(row->note, 7);
+    if(row->instr) putbits(row->instr, 4);
+    if(row->cmd)
+    {
+        putbits(row->cmd, 4);
+        putbits(row->param, 8);
+    }
+}
+
+static void writeheader(FILE *f, const uint8_t *song, uint32_t len)
+{
+    uint32_t i;
+
+    fprintf(f, "/**" EOL);
+    fprintf(f, "  ******************************************************************************" EOL);
+    fprintf(f, "  * @file           : track.h" EOL);
+    fprintf(f, "  * @brief          : Built-in song" EOL);
+    fprintf(f, "  ******************************************************************************" EOL);
+    fprintf(f, "  *" EOL);
+    fprintf(f, "  * Generated by Tools/songc - do not edit, run 'make -C Tools song'." EOL);
+    fprintf(f, "  *" EOL);
+    fprintf(f, "  */" EOL EOL);
+    fprintf(f, "#ifndef TRACK_H_INCLUDED" EOL);
+    fprintf(f, "#define TRACK_H_INCLUDED" EOL EOL);
+    fprintf(f, "#include <stdint.h>" EOL EOL);
+    fprintf(f, "#define MAXTRACK        0x%02x" EOL, tracks);
+    fprintf(f, "#define SONGLEN         0x%02x" EOL EOL, orders);
+    fprintf(f, "const uint8_t songdata[] = {");
+    for(i = 0; i < len; i++)
+    {
+        fprintf(f, "%s0x%02x,", i % 12 ? " " : EOL "    ", song[i]);
+    }
+    fprintf(f, EOL "};" EOL EOL);
+    fprintf(f, "#endif /* TRACK_H_INCLUDED */" EOL);
+}
+
+static int compile(const char *path, const char *hpath, const char *opath)
+{
+    uint32_t offset[1 + SONG_MAX_INSTRUMENTS + MAX_TRACKS];
+    uint32_t stop = 0, start, instrbytes, trackbytes, table, unshared = 0, len, songlen, i;
+    unsigned same = 0, moved = 0, defined = 0, used = 0;
+    uint8_t instruments = 0, p, ch, t;
+    uint16_t worst = 0;
+    uint8_t *song;
+
+    if(parse(path) || assign(path, &same, &moved)) return 1;
+
+    for(i = 1; i <= SONG_MAX_INSTRUMENTS; i++)
+    {
+        if(instrdef[i]) instruments = i;
+    }
+    for(t = 1; t <= MAX_TRACKS; t++)
+    {
+        defined += trackdef[t];
+        used += base[t] != 0;
+        for(i = 0; i < TRACKLEN && trackdef[t]; i++)
+        {
+            const row_t *row = &track[t][i];
+
+            if(row->instr && !instrdef[row->instr])
+            {
+                fprintf(stderr, "%s: track %02x uses instrument %x, which is not defined\n", path, t, row->instr);
+                return 1;
+            }
+            if(hpath && row->cmd && commands[row->cmd] == 't')
+            {
+                fprintf(stderr, "%s: track %02x row %02x sets the speed, which a track.h header cannot, "
+                        "use a container (-o)\n", path, t, i);
+                return 1;
+            }
+        }
+    }
+
+    /* Order list */
+    offset[0] = 0;
+    for(p = 0; p < orders; p++)
+    {
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            int k;
+
+            t = order[p][ch];
+            k = t ? transp[p][ch] + shift[t] : 0;
+            putbits(k != 0, 1);
+            putbits(t ? base[t] : 0, 6);
+            if(k) putbits(k & 15, 4);
+        }
+    }
+
+    /* Instruments, byte aligned; the missing ones share one stop line */
+    start = align();
+    fprintf(stderr, "%s: %u orders, %u instruments, %u tracks defined, %u used, %u packed "
+            "(%u duplicates, %u transposed copies)\n",
+            path, orders, instruments, defined, used, used - same - moved, same, moved);
+    fprintf(stderr, "  order list %u bytes", start);
+    for(i = 1; i <= SONG_MAX_INSTRUMENTS; i++)
+    {
+        if(!instrdef[i] && !stop)
+        {
+            stop = align();
+            bitpos += 16;
+        }
+    }
+    for(i = 1; i <= instruments; i++)
+    {
+        uint16_t l;
+
+        offset[i] = align();
+        if(!instrdef[i])
+        {
+            offset[i] = stop;
+            continue;
+        }
+        for(l = 0; l < instrlen[i]; l++)
+        {
+            putbits(instr[i][l][0], 8);
+            putbits(instr[i][l][1], 8);
+        }
+
+        /* Command 0 stops, its parameter is whatever byte follows */
+        l = instrlen[i] ? instr[i][instrlen[i] - 1][0] : 0;
+        if(!instrlen[i] || (commands[l] != '0' && commands[l] != 'j')) putbits(0, 8);
+    }
+    instrbytes = align() - start;
+
+    /* Tracks, byte aligned; the others never play */
+    start = align();
+    for(t = 1; t <= tracks; t++)
+    {
+        offset[instruments + t] = start;
+        if(base[t] != t) continue;
+        offset[instruments + t] = align();
+        for(i = 0; i < TRACKLEN; i++)
+        {
+            putrow(&track[t][i]);
+        }
+    }
+    for(t = 1; t <= tracks; t++)
+    {
+        if(base[t] && base[t] != t) offset[instruments + t] = offset[instruments + base[t]];
+    }
+    len = align();
+    trackbytes = len - start;
+
+    /* The same tracks without sharing */
+    for(t = 1; t <= MAX_TRACKS; t++)
+    {
+        uint32_t mark = bitpos;
+
+        if(!base[t]) continue;
+        for(i = 0; i < TRACKLEN; i++) putrow(&track[t][i]);
+        unshared += (bitpos - mark + 7) / 8;
+        bitpos = mark;
+    }
+    memset(data + len, 0, sizeof(data) - len);
+    fprintf(stderr, ", instruments %u, tracks %u (%u without sharing)\n", instrbytes, trackbytes, unshared);
+
+    /* Every program must wait or stop within the tick budget */
+    song = songfile_container(SONG_VERSION, offset, instruments, tracks, orders, data, len, &songlen);
+    if(!song) return 1;
+    for(i = 1; i <= instruments; i++)
+    {
+        uint16_t n = songfile_instrcost(song, songlen, i);
+
+        if(n == INSTR_RUNAWAY)
+        {
+            fprintf(stderr, "%s: instrument %x loops without a wait ('t') or stop\n", path, i);
+            free(song);
+            return 1;
+        }
+        if(n > CHIPTUNE_INSTR_BUDGET)
+        {
+            fprintf(stderr, "%s: instrument %x runs %u commands in a tick, over CHIPTUNE_INSTR_BUDGET (%u)\n",
+                    path, i, n, CHIPTUNE_INSTR_BUDGET);
+            free(song);
+            return 1;
+        }
+        if(n > worst) worst = n;
+    }
+    fprintf(stderr, "  at most %u instrument commands per channel and tick\n", worst);
+
+    if(hpath)
+    {
+        /* Version 1: 13-bit table of the order list, all 15 instruments and the tracks */
+        uint32_t entries = 16u + tracks;
+        uint8_t v1[V1_MAX] = { 0 };
+        FILE *f;
+
+        table = (entries * 13 + 7) / 8;
+        if(table + len > V1_MAX)
+        {
+            fprintf(stderr, "songc: %u bytes do not fit track.h's 13-bit offsets, use a container (-o)\n",
+                    table + len);
+            free(song);
+            return 1;
+        }
+        bitpos = 0;
+        memmove(data + table, data, len);
+        memset(data, 0, table);
+        for(i = 0; i < entries; i++)
+        {
+            uint32_t o;
+
+            if(i == 0) o = offset[0];
+            else if(i <= SONG_MAX_INSTRUMENTS) o = i <= instruments ? offset[i] : stop;
+            else o = offset[instruments + i - SONG_MAX_INSTRUMENTS];
+            putbits(table + o, 13);
+        }
+        memcpy(v1, data, table + len);
+        memmove(data, data + table, len);
+
+        f = fopen(hpath, "wb");
+        if(!f)
+        {
+            perror(hpath);
+            free(song);
+            return 1;
+        }
+        writeheader(f, v1, table + len);
+        if(fclose(f))
+        {
+            perror(hpath);
+            free(song);
+            return 1;
+        }
+        fprintf(stderr, "  %s: %u bytes (resource table %u)\n", hpath, table + len, table);
+    }
+
+    if(opath)
+    {
+        FILE *f = fopen(opath, "wb");
+
+        if(!f || fwrite(song, 1, songlen, f) != songlen || fclose(f))
+        {
+            perror(opath);
+            free(song);
+            return 1;
+        }
+        fprintf(stderr, "  %s: %u bytes (resource table %u)\n", opath, songlen, songlen - len - SONG_HEADER);
+    }
+    free(song);
+
+    return 0;
+}
+
+static void printnote(uint8_t note)
+{
+    if(note) printf("%s%x", notenames[(note - 1) % 12], (note - 1) / 12);
+    else printf("---");
+}
+
+static int decompile(const char *path)
+{
+    uint32_t len, bit, entries, off[1 + SONG_MAX_INSTRUMENTS + SONG_MAX_TRACKS], i, j;
+    uint8_t *song = songfile_load(path, &len);
+    uint8_t size, p, ch, r;
+
+    if(!song) return 1;
+    size = song[3];
+    entries = 1u + song[4] + song[5];
+    if(song[5] > MAX_TRACKS) song[5] = MAX_TRACKS;
+    for(i = 0; i < entries; i++)
+    {
+        off[i] = 0;
+        for(j = size; j; j--) off[i] = (off[i] << 8) | song[SONG_HEADER + i * size + j - 1];
+    }
+
+    printf("; Decompiled from %s by Tools/songc -d\n\nsong\n", path);
+    bit = off[0] * 8;
+    for(p = 0; p < song[6]; p++)
+    {
+        printf("   ");
+        for(ch = 0; ch < CHIPTUNE_CHANNELS; ch++)
+        {
+            uint8_t gottransp = getbits(song, len, &bit, 1);
+            uint8_t t = getbits(song, len, &bit, 6);
+            int k = gottransp ? (int)getbits(song, len, &bit, 4) : 0;
+            char ref[16];
+
+            if(k > 7) k -= 16;
+            if(!t) strcpy(ref, "--");
+            else if(k) sprintf(ref, "%02x%+d", t, k);
+            else sprintf(ref, "%02x", t);
+            printf(ch + 1 < CHIPTUNE_CHANNELS ? " %-5s" : " %s\n", ref);
+        }
+    }
+
+    /* An instrument ends where the next resource starts, with a stop byte */
+    for(i = 1; i <= song[4]; i++)
+    {
+        uint32_t end = len;
+
+        for(j = 0; j < entries; j++)
+        {
+            if(off[j] > off[i] && off[j] < end) end = off[j];
+        }
+        printf("\ninstrument %x\n", (unsigned)i);
+        for(j = off[i]; j + 1 < end && j - off[i] < 2 * INSTR_LINES; j += 2)
+        {
+            printf("    %c%02x\n", commands[song[j] < sizeof(commands) - 1 ? song[j] : 0], song[j + 1]);
+        }
+    }
+
+    for(i = 1; i <= song[5]; i++)
+    {
+        printf("\ntrack %02x\n", (unsigned)i);
+        bit = off[song[4] + i] * 8;
+        for(r = 0; r < TRACKLEN; r++)
+        {
+            uint8_t fields = getbits(song, len, &bit, 3);
+            uint8_t note = fields & 1 ? getbits(song, len, &bit, 7) : 0;
+            uint8_t in = fields & 2 ? getbits(song, len, &bit, 4) : 0;
+            uint8_t cmd = fields & 4 ? getbits(song, len, &bit, 4) : 0;
+            uint8_t param = fields & 4 ? getbits(song, len, &bit, 8) : 0;
+
+            if(!note && !in && !cmd) continue;
+            printf("    %02x ", r);
+            printnote(note);
+            if(in) printf(" %x", in);
+            else printf(" .");
+            if(cmd) printf(" %c%02x\n", commands[cmd], param);
+            else printf(" ...\n");
+        }
+    }
+    free(song);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *hpath = NULL, *opath = NULL;
+    int opt = 1;
+
+    if(argc == 3 && !strcmp(argv[1], "-d")) return decompile(argv[2]);
+
+    while(opt + 1 < argc)
+    {
+        if(!strcmp(argv[opt], "-h")) hpath = argv[++opt];
+        else if(!strcmp(argv[opt], "-o")) opath = argv[++opt];
+        else break;
+        opt++;
+    }
+    if(argc - opt != 1)
+    {
+        fprintf(stderr, "usage: songc [-h track.h] [-o song.sg] song.txt\n"
+                        "       songc -d song > song.txt\n");
+        return 2;
+    }
+
+    return compile(argv[opt], hpath, opath);
+}
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file           : songconv.c
+  * @brief          : Converts a song header to a version 2 song container
+  ******************************************************************************
+  *
+  * Usage: songconv song.h song.sg
+  *
+  * song.h is in the format of Core/Inc/track.h. The container (format in
+  * chiptune.h, SONG_VERSION) plays through Chiptune_PlaySong() or as a
+  * song bank entry, and is what Tools/render -f loads.
+  *
+  * On stderr it reports the counts and the size of both resource tables.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+
+int main(int argc, char **argv)
+{
+    uint32_t len;
+    uint8_t *song;
+    FILE *f;
+
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: songconv song.h song.sg\n");
+        return 2;
+    }
+
+    song = songfile_load(argv[1], &len);
+    if(!song) return 1;
+
+    f = fopen(argv[2], "wb");
+    if(!f || fwrite(song, 1, len, f) != len || fclose(f))
+    {
+        perror(argv[2]);
+        free(song);
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %u instruments, %u tracks, %u orders, %u bytes\n",
+            argv[2], song[4], song[5], song[6], len);
+    fprintf(stderr, "  resource table %u bytes of %u-bit offsets (version 1: %u bytes of 13-bit)\n",
+            (1 + song[4] + song[5]) * song[3], 8 * song[3], ((16 + song[5]) * 13 + 7) / 8);
+    free(song);
+
+    return 0;
+}
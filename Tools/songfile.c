@@ -0,0 +1,317 @@
+/**
+  ******************************************************************************
+  * @file           : songfile.c
+  * @brief          : Song files for the host tools
+  ******************************************************************************
+  *
+  * A track.h-format header has the MAXTRACK and SONGLEN defines and the
+  * songdata[] bytes. Converting it only rewrites the resource table: the
+  * bit-packed order list, instruments and tracks are copied as they are,
+  * so the container plays the same samples.
+  *
+  * Containers are mapped rather than read: the engine plays straight from
+  * the page cache and checks every read against the length.
+  *
+  * An instrument program has no end of its own: playroutine runs its
+  * 2-byte lines until a stop or a wait, falling through into whatever
+  * follows, so songfile_instrcost() walks the packed bytes the same way.
+  *
+  */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+
+/* Returns the file contents NUL terminated, or NULL */
+static char *readfile(const char *path, uint32_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    char *text;
+    long n;
+
+    if(!f)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    text = malloc(n + 1);
+    if(!text || fread(text, 1, n, f) != (size_t)n)
+    {
+        fprintf(stderr, "%s: read error\n", path);
+        fclose(f);
+        free(text);
+        return NULL;
+    }
+    fclose(f);
+    text[n] = 0;
+    *size = n;
+
+    return text;
+}
+
+static long define(const char *text, const char *name)
+{
+    const char *p = text;
+    size_t len = strlen(name);
+
+    while((p = strstr(p, "#define")) != NULL)
+    {
+        p += 7;
+        while(*p == ' ' || *p == '\t') p++;
+        if(!strncmp(p, name, len) && (p[len] == ' ' || p[len] == '\t'))
+        {
+            return strtol(p + len, NULL, 0);
+        }
+    }
+
+    return -1;
+}
+
+/* Reads a 13-bit table entry, LSB first like the engine's readchunk() */
+static uint32_t chunk13(const uint8_t *data, uint32_t index)
+{
+    uint32_t v = 0, bit = index * 13;
+    uint8_t i;
+
+    for(i = 0; i < 13; i++, bit++)
+    {
+        v |= ((data[bit / 8] >> (bit % 8)) & 1u) << i;
+    }
+
+    return v;
+}
+
+/*
+ * MAXTRACK may count more tracks than the table holds (the tracker-exported
+ * track.h said 0x92 for 57 entries): the engine never reads the entries
+ * overlapping the data, so the table ends where the first resource starts.
+ */
+uint8_t *songfile_convert(const uint8_t *data, uint32_t bytes, uint8_t orders, uint8_t tracks,
+                          uint32_t *len)
+{
+    uint32_t offset[16 + SONG_MAX_TRACKS], entries, first = bytes, i;
+
+    if(!orders || orders > SONG_MAX_ORDERS || tracks > SONG_MAX_TRACKS || bytes < (16 * 13 + 7) / 8)
+    {
+        return NULL;
+    }
+
+    for(i = 0; i < 16; i++)
+    {
+        offset[i] = chunk13(data, i);
+        if(offset[i] < first) first = offset[i];
+    }
+    if(first < (16 * 13 + 7) / 8 || first >= bytes) return NULL;
+    if(16u + tracks > first * 8 / 13) tracks = first * 8 / 13 - 16;
+    entries = 16u + tracks;
+    for(i = 16; i < entries; i++)
+    {
+        offset[i] = chunk13(data, i);
+    }
+    for(i = 0; i < entries; i++)
+    {
+        if(offset[i] < first || offset[i] >= bytes) return NULL;
+    }
+
+    for(i = 0; i < entries; i++)
+    {
+        offset[i] -= first;
+    }
+
+    /* Version 2: a track row's 't' stays the wait it is in version 1 */
+    return songfile_container(2, offset, SONG_MAX_INSTRUMENTS, tracks, orders, data + first, bytes - first, len);
+}
+
+uint8_t *songfile_container(uint8_t version, const uint32_t *offset, uint8_t instruments, uint8_t tracks,
+                            uint8_t orders, const uint8_t *data, uint32_t bytes, uint32_t *len)
+{
+    uint32_t entries = 1u + instruments + tracks, size = 2, start, i;
+    uint8_t *out;
+
+    start = SONG_HEADER + entries * size;
+    if(start + bytes > 0x10000)
+    {
+        size = 4;
+        start = SONG_HEADER + entries * size;
+    }
+    *len = start + bytes;
+    out = malloc(*len);
+    if(!out) return NULL;
+
+    out[0] = 'S';
+    out[1] = 'G';
+    out[2] = version;
+    out[3] = size;
+    out[4] = instruments;
+    out[5] = tracks;
+    out[6] = orders;
+    out[7] = 0;
+    for(i = 0; i < entries; i++)
+    {
+        uint32_t v = start + offset[i];
+        uint8_t b;
+
+        for(b = 0; b < size; b++) out[SONG_HEADER + i * size + b] = (uint8_t)(v >> (8 * b));
+    }
+    memcpy(out + start, data, bytes);
+
+    return out;
+}
+
+uint8_t *songfile_load(const char *path, uint32_t *len)
+{
+    uint32_t size, bytes = 0;
+    char *text = readfile(path, &size), *p, *end;
+    long songlen, maxtrack;
+    uint8_t *data, *out;
+
+    if(!text) return NULL;
+
+    if(size >= SONG_HEADER && text[0] == 'S' && text[1] == 'G')
+    {
+        if(text[2] < 2 || text[2] > SONG_VERSION)
+        {
+            fprintf(stderr, "%s: song container version %u, expected 2 to %u\n", path, text[2], SONG_VERSION);
+            free(text);
+            return NULL;
+        }
+        *len = size;
+        return (uint8_t *)text;
+    }
+
+    songlen = define(text, "SONGLEN");
+    maxtrack = define(text, "MAXTRACK");
+    p = strstr(text, "songdata");
+    p = p ? strchr(p, '{') : NULL;
+    if(songlen < 1 || songlen > SONG_MAX_ORDERS || maxtrack < 0 || maxtrack > SONG_MAX_TRACKS || !p)
+    {
+        fprintf(stderr, "%s: not a song container or header, or SONGLEN/MAXTRACK out of range\n", path);
+        free(text);
+        return NULL;
+    }
+
+    /* The bytes are fewer than the characters, convert in place */
+    data = (uint8_t *)text;
+    for(p++; *p && *p != '}'; p = end)
+    {
+        unsigned long v = strtoul(p, &end, 0);
+
+        if(end == p)
+        {
+            end++;
+            continue;
+        }
+        if(v > 0xff)
+        {
+            fprintf(stderr, "%s: bad byte 0x%lx\n", path, v);
+            free(text);
+            return NULL;
+        }
+        data[bytes++] = (uint8_t)v;
+    }
+
+    out = songfile_convert(data, bytes, (uint8_t)songlen, (uint8_t)maxtrack, len);
+    free(text);
+    if(!out) fprintf(stderr, "%s: malformed resource table\n", path);
+
+    return out;
+}
+
+uint16_t songfile_instrcost(const uint8_t *song, uint32_t len, uint8_t num)
+{
+    static const char commands[] = CHIPTUNE_COMMANDS;
+    uint8_t queued[256] = { 1 }, todo[256] = { 0 }, size = song[3], b;
+    uint16_t worst = 0, pending = 1;
+    uint32_t base = 0;
+
+    /* Instruments the container does not have read as zeros: a stop */
+    if(num > song[4]) return 1;
+    for(b = size; b; b--) base = (base << 8) | song[SONG_HEADER + num * size + b - 1];
+
+    /* Each tick starts at line 0 or after a wait; walk each start once */
+    while(pending)
+    {
+        uint8_t seen[256] = { 0 }, pos = todo[--pending];
+        uint16_t n = 0;
+
+        for(;;)
+        {
+            uint8_t cmd = base + 2u * pos < len ? song[base + 2u * pos] : 0;
+            uint8_t param = base + 2u * pos + 1 < len ? song[base + 2u * pos + 1] : 0;
+            char c = cmd < sizeof(commands) - 1 ? commands[cmd] : '0';
+
+            if(seen[pos]) return INSTR_RUNAWAY;
+            seen[pos] = 1;
+            n++;
+            pos++;
+            if(c == '0') break;
+            if(c == 'j') pos = param;
+            if(c == 't' && param)
+            {
+                /* The next tick resumes at the next line */
+                if(!queued[pos]) todo[pending++] = pos;
+                queued[pos] = 1;
+                break;
+            }
+        }
+        if(n > worst) worst = n;
+    }
+
+    return worst;
+}
+
+int songfile_map(const char *path, songmap_t *map)
+{
+    struct stat st;
+    void *p;
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0 || fstat(fd, &st))
+    {
+        perror(path);
+        if(fd >= 0) close(fd);
+        return 1;
+    }
+    if(st.st_size < SONG_HEADER || st.st_size > UINT32_MAX)
+    {
+        fprintf(stderr, "%s: %lld bytes is not a song\n", path, (long long)st.st_size);
+        close(fd);
+        return 1;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+    {
+        perror(path);
+        return 1;
+    }
+
+    map->data = p;
+    map->len = st.st_size;
+    map->mapped = 1;
+    if(map->data[0] == 'S' && map->data[1] == 'G') return 0;
+
+    /* A header: convert it */
+    munmap(p, st.st_size);
+    map->mapped = 0;
+    map->data = songfile_load(path, &map->len);
+
+    return map->data == NULL;
+}
+
+void songfile_unmap(songmap_t *map)
+{
+    if(map->mapped) munmap((void *)map->data, map->len);
+    else free((void *)map->data);
+    map->data = NULL;
+}
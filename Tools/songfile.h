@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : songfile.h
+  * @brief          : Song files for the host tools
+  ******************************************************************************
+  *
+  * Reads songs as containers (format in chiptune.h, SONG_VERSION) whether
+  * they come as a container or as a track.h-format header, which is
+  * converted to version 2.
+  *
+  */
+
+#ifndef __SONGFILE_H
+#define __SONGFILE_H
+
+#include <stdint.h>
+
+/* A song file in memory: mapped when it is a container, converted if not */
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    uint8_t mapped;
+} songmap_t;
+
+/* Returns the song as a malloc'd container, or NULL with a message on stderr */
+uint8_t *songfile_load(const char *path, uint32_t *len);
+
+/* Maps a container read-only, no copy; returns 0, or 1 with a message on stderr */
+int songfile_map(const char *path, songmap_t *map);
+void songfile_unmap(songmap_t *map);
+
+/* songfile_instrcost() of a program that can loop without waiting or stopping */
+#define INSTR_RUNAWAY  0xffff
+
+/*
+ * Worst-case commands instrument num of a container runs in one tick,
+ * from its start or from any wait ('t'), as playroutine steps through it;
+ * INSTR_RUNAWAY if a 'j' loop never waits.
+ */
+uint16_t songfile_instrcost(const uint8_t *song, uint32_t len, uint8_t num);
+
+/* Version 2 container of a version 1 song (track.h's songdata), NULL if it is malformed */
+uint8_t *songfile_convert(const uint8_t *data, uint32_t bytes, uint8_t orders, uint8_t tracks,
+                          uint32_t *len);
+
+/*
+ * Container of resources packed in 'data', of 'version' 2 or 3: offset[]
+ * holds the order list, then instruments 1..n and tracks 1..n, from the
+ * start of 'data'. The offset size is picked to fit.
+ */
+uint8_t *songfile_container(uint8_t version, const uint32_t *offset, uint8_t instruments, uint8_t tracks,
+                            uint8_t orders, const uint8_t *data, uint32_t bytes, uint32_t *len);
+
+#endif /* __SONGFILE_H */
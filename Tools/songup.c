@@ -0,0 +1,427 @@
+/**
+  ******************************************************************************
+  * @file           : songup.c
+  * @brief          : Pushes a song to a running unit over the upload protocol
+  ******************************************************************************
+  *
+  * Usage: songup -p port song
+  *        songup -t [-e rate] song
+  *
+  * Sends a song container, or a track.h-format header converted to one, in
+  * the frames of Core/Inc/upload.h, waiting for each reply and sending a
+  * frame again on a NAK for a damaged frame or busy flash, or after
+  * REPLY_MS with no reply.
+  *
+  * -p sends it over a serial port at UPLOAD_BAUD, to a board built with
+  * CHIPTUNE_UPLOAD=1.
+  *
+  * -t plays the board here: a child process sends over a pipe to
+  * Core/Src/upload.c on the flash stand-in, polled every millisecond of
+  * audio before Chiptune_Process() as the firmware's main loop does, and
+  * one byte in 'rate' (default 500) is damaged or lost each way. The
+  * sender abandons a first upload half way and starts over. Then it checks
+  * that the audio up to the switch is the song undisturbed and from it on
+  * the same as Chiptune_PlaySong() called in that poll, that the second
+  * upload resumed in the first one's slot and nothing was erased once the
+  * audio started, and that a restart plays the song from its slot.
+  *
+  */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "chiptune.h"
+#include "songfile.h"
+#include "upload.h"
+
+#define POLL_FRAMES     (CHIPTUNE_SAMPLE_RATE / 1000)   /* main loop HAL_Delay(1) */
+#define REPLY_MS        100
+#define BUSY_MS         2
+#define MAX_TRIES       50
+#define AFTER_FRAMES    (2 * CHIPTUNE_SAMPLE_RATE)      /* played after the switch */
+#define MAX_FRAMES      (120 * CHIPTUNE_SAMPLE_RATE)
+
+static const char *const errors[] = {
+    "", "damaged frame", "busy", "out of sequence", "song too large for a slot",
+    "no erased slot, restart the unit", "flash programming failed", "song refused"
+};
+
+/* The board's side of -t: its pipe ends and what is damaged on them */
+static int boardin, boardout;
+static uint32_t damagerate, rxseed = 1, txseed = 2;
+static int waiting;
+
+/* ------------------------------------------------------------------ sender */
+
+static int writeall(int fd, const uint8_t *b, size_t n)
+{
+    while(n)
+    {
+        ssize_t k = write(fd, b, n);
+
+        if(k < 0 && errno == EINTR) continue;
+        if(k <= 0) return 1;
+        b += k;
+        n -= k;
+    }
+
+    return 0;
+}
+
+/* Waits for the reply to 'seq': 0 for an ACK, the error of a NAK, -1 if
+ * none comes; other replies and damaged ones are skipped */
+static int awaitreply(int fd, uint8_t seq)
+{
+    struct pollfd p = { fd, POLLIN, 0 };
+    uint8_t f[8], b;
+    uint16_t have = 0;
+
+    while(poll(&p, 1, REPLY_MS) > 0)
+    {
+        if(read(fd, &b, 1) != 1) return -1;
+        if(!have && b != UPLOAD_SYNC) continue;
+        f[have++] = b;
+        if(have == 5 && (f[3] > 1 || f[4]))
+        {
+            have = 0;
+            continue;
+        }
+        if(have < 5 || have < 7 + f[3]) continue;
+        have = 0;
+        if(Upload_Crc16(f + 1, 4 + f[3], 0xFFFF) != (f[5 + f[3]] | f[6 + f[3]] << 8) || f[2] != seq)
+        {
+            continue;
+        }
+        if(f[1] == UPLOAD_ACK && !f[3]) return 0;
+        if(f[1] == UPLOAD_NAK && f[3] == 1) return f[5];
+    }
+
+    return -1;
+}
+
+/* Sends a frame until it is acknowledged; 0, or 1 with a message */
+static int sendframe(int out, int in, uint8_t type, const uint8_t *payload, uint16_t len, uint32_t *again)
+{
+    static uint8_t seq;
+    uint8_t f[UPLOAD_FRAME_MAX];
+    uint16_t n = Upload_Frame(f, type, seq, payload, len);
+    int tries, r;
+
+    for(tries = 0; tries < MAX_TRIES; tries++)
+    {
+        if(tries) (*again)++;
+        if(writeall(out, f, n))
+        {
+            fprintf(stderr, "songup: write failed\n");
+            return 1;
+        }
+        r = awaitreply(in, seq);
+        if(!r)
+        {
+            seq++;
+            return 0;
+        }
+        if(r == UPLOAD_ERR_BUSY) usleep(BUSY_MS * 1000);
+        else if(r > 0 && r != UPLOAD_ERR_CRC)
+        {
+            fprintf(stderr, "songup: %s\n", r < (int)(sizeof(errors) / sizeof(errors[0])) ? errors[r] : "refused");
+            return 1;
+        }
+    }
+    fprintf(stderr, "songup: no reply after %d tries\n", MAX_TRIES);
+
+    return 1;
+}
+
+static void wr32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+/* The whole upload, BEGIN to END, or with 'stop' under 'len' BEGIN and the
+ * chunks before it only; 0, or 1 with a message */
+static int push(int out, int in, const uint8_t *song, uint32_t len, uint32_t stop)
+{
+    uint8_t payload[4 + UPLOAD_CHUNK];
+    uint32_t offset, again = 0, frames = 2;
+
+    wr32(payload, len);
+    wr32(payload + 4, Upload_Crc32(song, len, 0));
+    if(sendframe(out, in, UPLOAD_BEGIN, payload, 8, &again)) return 1;
+    for(offset = 0; offset < len && offset < stop; offset += UPLOAD_CHUNK, frames++)
+    {
+        uint16_t n = len - offset < UPLOAD_CHUNK ? len - offset : UPLOAD_CHUNK;
+
+        wr32(payload, offset);
+        memcpy(payload + 4, song + offset, n);
+        if(sendframe(out, in, UPLOAD_DATA, payload, 4 + n, &again)) return 1;
+    }
+    if(stop < len)
+    {
+        fprintf(stderr, "abandoned after %u bytes in %u frames, %u sent again\n", offset, frames - 1, again);
+        return 0;
+    }
+    if(sendframe(out, in, UPLOAD_END, NULL, 0, &again)) return 1;
+    fprintf(stderr, "sent %u bytes in %u frames, %u sent again\n", len, frames, again);
+
+    return 0;
+}
+
+static int pushport(const char *port, const uint8_t *song, uint32_t len)
+{
+    struct termios t;
+    int fd = open(port, O_RDWR | O_NOCTTY), failed;
+
+    if(fd < 0 || tcgetattr(fd, &t))
+    {
+        fprintf(stderr, "songup: cannot open %s\n", port);
+        return 1;
+    }
+    cfmakeraw(&t);
+    cfsetispeed(&t, B115200);
+    cfsetospeed(&t, B115200);
+    t.c_cflag |= CLOCAL | CREAD;
+    if(tcsetattr(fd, TCSANOW, &t))
+    {
+        fprintf(stderr, "songup: cannot set up %s\n", port);
+        close(fd);
+        return 1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    failed = push(fd, fd, song, len, len);
+    close(fd);
+
+    return failed;
+}
+
+/* ------------------------------------------------------------ board (-t) */
+
+/* Whether the next byte on a direction is damaged: a bit flipped, or it is
+ * lost (returns 2) */
+static int damage(uint32_t *seed, uint8_t *b)
+{
+    *seed = *seed * 1103515245 + 12345;
+    if(!damagerate || (*seed >> 8) % damagerate) return 0;
+    if(*seed & 0x80) return 2;
+    *b ^= 1 << (*seed >> 4 & 7);
+
+    return 1;
+}
+
+/* Pipe transport; while the upload runs, a read waits up to a
+ * millisecond for bytes, so the audio roughly keeps to the sender */
+static uint16_t pipread(uint8_t *buf, uint16_t max)
+{
+    struct pollfd p = { boardin, POLLIN, 0 };
+    ssize_t n;
+    uint16_t i, k = 0;
+
+    if(poll(&p, 1, waiting) <= 0 || !(p.revents & POLLIN)) return 0;
+    n = read(boardin, buf, max);
+    for(i = 0; i < n; i++)
+    {
+        if(damage(&rxseed, &buf[i]) != 2) buf[k++] = buf[i];
+    }
+
+    return k;
+}
+
+static void pipwrite(const uint8_t *buf, uint16_t len)
+{
+    uint8_t out[16];
+    uint16_t i, k = 0;
+
+    for(i = 0; i < len && k < sizeof(out); i++)
+    {
+        out[k] = buf[i];
+        if(damage(&txseed, &out[k]) != 2) k++;
+    }
+    writeall(boardout, out, k);
+}
+
+static const upload_transport_t pipe_transport = { pipread, pipwrite };
+
+/* One frame of main loop and audio interrupt; returns the L/R frame */
+static uint32_t step(uint32_t n, uint8_t upload)
+{
+    const uint16_t *buf = getAudioBuffer();
+    uint32_t i = (2 * n) % AUDIO_BUFFER_SIZE;
+
+    if(n % POLL_FRAMES == 0)
+    {
+        hal_stub_tick = n / POLL_FRAMES;
+        if(upload) Upload_Process();
+        Chiptune_Process();
+    }
+    Chiptune_AudioCallback();
+
+    return buf[i] | (uint32_t)buf[i + 1] << 16;
+}
+
+static int selftest(const uint8_t *song, uint32_t len)
+{
+    static uint32_t board[MAX_FRAMES], ref[MAX_FRAMES];
+    int tohost[2], toboard[2], status = 0;
+    uint32_t n, frames, switchat = 0, erases, words, i;
+    upload_stats_t st;
+    pid_t child;
+    int failed = 0;
+
+    /* Leftovers in both slots, erased by Upload_Init() */
+    for(i = 0; i < HAL_STUB_FLASH_SIZE; i++) hal_stub_flash[i] = i * 37 >> 3;
+
+    if(pipe(tohost) || pipe(toboard))
+    {
+        fprintf(stderr, "songup: pipe failed\n");
+        return 1;
+    }
+    child = fork();
+    if(child < 0)
+    {
+        fprintf(stderr, "songup: fork failed\n");
+        return 1;
+    }
+    if(!child)
+    {
+        close(toboard[0]);
+        close(tohost[1]);
+        /* Half way, the sender starts over */
+        _exit(push(toboard[1], tohost[0], song, len, len / 2) || push(toboard[1], tohost[0], song, len, len));
+    }
+    close(toboard[1]);
+    close(tohost[0]);
+    boardin = toboard[0];
+    boardout = tohost[1];
+
+    Chiptune_Init();
+    Upload_Init(&pipe_transport);
+    erases = hal_stub_flash_erases;
+    waiting = 1;
+    for(n = 0; n < MAX_FRAMES && (!switchat || n < switchat + AFTER_FRAMES); n++)
+    {
+        board[n] = step(n, 1);
+        if(n % POLL_FRAMES) continue;
+        Upload_GetStats(&st);
+        if(st.uploads && !switchat)
+        {
+            switchat = n;
+            waiting = 0;
+        }
+        if(!switchat && waitpid(child, &status, WNOHANG) == child)
+        {
+            child = 0;
+            if(!WIFEXITED(status) || WEXITSTATUS(status)) break;
+        }
+    }
+    frames = n;
+    words = hal_stub_flash_words;
+    /* The sender may still be repeating a frame whose reply was lost */
+    waiting = 1;
+    while(child && waitpid(child, &status, WNOHANG) != child) Upload_Process();
+    close(boardin);
+    close(boardout);
+    if(!WIFEXITED(status) || WEXITSTATUS(status))
+    {
+        fprintf(stderr, "songup: the sender failed\n");
+        return 1;
+    }
+    if(!switchat)
+    {
+        fprintf(stderr, "songup: the board never switched to the song\n");
+        return 1;
+    }
+
+    Upload_GetStats(&st);
+    fprintf(stderr, "board: %u frames, %u damaged, %u refused busy, %u refused otherwise; %u flash words programmed\n",
+            st.frames, st.damaged, st.busy, st.refused, words);
+    fprintf(stderr, "  switched %.3f s into the song, %u erases at startup, %u while playing, "
+            "%u uploads resumed\n", (double)switchat / CHIPTUNE_SAMPLE_RATE, erases,
+            hal_stub_flash_erases - erases, st.resumed);
+
+    /* The same main loop with the song played from RAM at that poll */
+    Chiptune_Init();
+    for(n = 0; n < frames; n++)
+    {
+        if(n == switchat && Chiptune_PlaySong(song, len) != HAL_OK)
+        {
+            fprintf(stderr, "songup: the engine refuses the song\n");
+            return 1;
+        }
+        ref[n] = step(n, 0);
+    }
+    for(n = 0; n < frames && board[n] == ref[n]; n++);
+    /* The second upload in the abandoned one's slot, without an erase */
+    if(n < frames || hal_stub_flash_erases != erases || st.resumed != 1)
+    {
+        failed = 1;
+    }
+    fprintf(stderr, "playback: %s\n", failed ? "FAILED" :
+            "the song undisturbed by the upload, switched at a tick as by Chiptune_PlaySong()");
+    if(n < frames)
+    {
+        fprintf(stderr, "  first difference at frame %u\n", n);
+    }
+
+    /* A restart plays it from the slot, and erases nothing */
+    erases = hal_stub_flash_erases;
+    Chiptune_Init();
+    Upload_Init(&pipe_transport);
+    for(n = 0; n < AFTER_FRAMES; n++) board[n] = step(n, 0);
+    Chiptune_Init();
+    Chiptune_PlaySong(song, len);
+    for(n = 0; n < AFTER_FRAMES && step(n, 0) == board[n]; n++);
+    if(n < AFTER_FRAMES || Chiptune_GetSong() != SONG_EXTERNAL || hal_stub_flash_erases != erases)
+    {
+        failed |= 2;
+    }
+    fprintf(stderr, "restart: %s\n", failed & 2 ? "FAILED" : "plays the uploaded song from its slot");
+
+    return failed != 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *port = NULL;
+    unsigned long rate = 500;
+    int test = 0, i, failed;
+    uint8_t *song;
+    uint32_t len;
+
+    for(i = 1; i < argc - 1; i++)
+    {
+        if(!strcmp(argv[i], "-p") && i + 2 < argc) port = argv[++i];
+        else if(!strcmp(argv[i], "-e") && i + 2 < argc) rate = strtoul(argv[++i], NULL, 0);
+        else if(!strcmp(argv[i], "-t")) test = 1;
+        else break;
+    }
+    if(i != argc - 1 || !port == !test)
+    {
+        fprintf(stderr, "usage: songup -p port song\n"
+                        "       songup -t [-e rate] song\n");
+        return 2;
+    }
+
+    song = songfile_load(argv[i], &len);
+    if(!song) return 1;
+    if(len > UPLOAD_SONG_MAX)
+    {
+        fprintf(stderr, "songup: %u bytes, a slot holds %u\n", len, UPLOAD_SONG_MAX);
+        free(song);
+        return 1;
+    }
+    damagerate = rate;
+    failed = test ? selftest(song, len) : pushport(port, song, len);
+    free(song);
+
+    return failed;
+}
@@ -0,0 +1,244 @@
+/**
+  ******************************************************************************
+  * @file           : svfbench.c
+  * @brief          : Measures the channel filter's cost and checks its stability
+  ******************************************************************************
+  *
+  * Usage: svfbench [-s seconds]
+  *
+  * Plays the built-in song with the filter ('c' and 'q', see FILTER_LP in
+  * chiptune.h) turned on for 0 to 4 of its channels through
+  * CHIPTUNE_EV_COMMAND, and times the audio callback for each. The cost
+  * of a filtered voice is the fitted slope, in host ns per output sample
+  * and per sample rendered at this build's rate. Built with
+  * CHIPTUNE_OVERSAMPLE > 1 (svfbench-os2, svfbench-os4) it gives the
+  * figures for those render rates. Host time says nothing of the target's
+  * share of a sample period: on the board, Chiptune_GetStats() mix with
+  * CHIPTUNE_PROFILE has the cycles, to compare with and without a filter.
+  *
+  * Then it sweeps the cutoff table's points, every resonance and every
+  * mode: an effect on channel 0, with the song's other channels muted,
+  * drives the filter with a full-scale saw, then silences its input. Every
+  * run must ring down to the rounding floor, SETTLE_FLOOR, before the
+  * effect ends.
+  *
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chiptune.h"
+
+#define TICK_FRAMES     (CHIPTUNE_SAMPLE_RATE * 5 / 2 / CHIPTUNE_TEMPO)
+#define POLL_FRAMES     (CHIPTUNE_SAMPLE_RATE / 1000)   /* main loop HAL_Delay(1) */
+#define MAX_SECONDS     3600
+#define RUNS            3       /* timings per voice count, the fastest is kept */
+
+/* Sweep: ticks of saw into the filter, then of silence to ring down in */
+#define DRIVE_TICKS     10
+#define SETTLE_TICKS    40
+#define SWEEP_FRAMES    ((DRIVE_TICKS + SETTLE_TICKS) * TICK_FRAMES)
+#define SETTLE_FLOOR    32      /* residual allowed in the last tick, -60 dBFS: the
+                                 * rounding noise a resonance of 10 holds up */
+
+static double elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+/* Command number of a letter in CHIPTUNE_COMMANDS */
+static uint8_t cmdnum(char cmd)
+{
+    static const char commands[] = CHIPTUNE_COMMANDS;
+
+    return strchr(commands, cmd) - commands;
+}
+
+static void post(uint8_t type, uint8_t ch, uint8_t value, uint8_t arg)
+{
+    chiptune_event_t e = { Chiptune_GetTime(), type, ch, value, arg };
+
+    if(Chiptune_PostEvent(&e) != HAL_OK)
+    {
+        fprintf(stderr, "svfbench: event queue full\n");
+        exit(1);
+    }
+}
+
+static int16_t output(void)
+{
+    return (int16_t)(lastsample16 ^ 0x8000);
+}
+
+/* Host ns per output sample of the song with 'filtered' channels filtered */
+static double cost(uint8_t filtered, uint32_t frames)
+{
+    struct timespec t0, t1;
+    uint32_t n;
+    uint8_t ch;
+
+    Chiptune_Init();
+    for(ch = 0; ch < filtered; ch++)
+    {
+        /* Mid cutoff, full resonance, low-pass: the mode costs the same */
+        post(CHIPTUNE_EV_COMMAND, ch, cmdnum('c'), 0x80);
+        post(CHIPTUNE_EV_COMMAND, ch, cmdnum('q'), 0xf0 | FILTER_LP);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(n = 0; n < frames; n++)
+    {
+        if(n % POLL_FRAMES == 0) Chiptune_Process();
+        Chiptune_AudioCallback();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for(ch = 0; ch < filtered; ch++)
+    {
+        if(!(osc[ch].filter & FILTER_MODES))
+        {
+            fprintf(stderr, "svfbench: the song turned channel %u's filter off\n", ch);
+            exit(1);
+        }
+    }
+
+    return elapsed(&t0, &t1) / frames;
+}
+
+static int measure(uint32_t frames)
+{
+    double ns[CHIPTUNE_CHANNELS + 1], slope, num = 0, den = 0, mean = 0;
+    uint8_t k, r;
+
+    for(k = 0; k <= CHIPTUNE_CHANNELS; k++)
+    {
+        ns[k] = 0;
+        for(r = 0; r < RUNS; r++)
+        {
+            double t = cost(k, frames);
+
+            if(!r || t < ns[k]) ns[k] = t;
+        }
+        mean += ns[k] / (CHIPTUNE_CHANNELS + 1);
+    }
+    /* Least-squares slope over the voice counts */
+    for(k = 0; k <= CHIPTUNE_CHANNELS; k++)
+    {
+        num += (k - CHIPTUNE_CHANNELS / 2.0) * (ns[k] - mean);
+        den += (k - CHIPTUNE_CHANNELS / 2.0) * (k - CHIPTUNE_CHANNELS / 2.0);
+    }
+    slope = num / den;
+
+    printf("filter cost, %u Hz render (%ux), host ns:\n", CHIPTUNE_SAMPLE_RATE * CHIPTUNE_OVERSAMPLE,
+           CHIPTUNE_OVERSAMPLE);
+    printf("  %-16s %12s\n", "filtered voices", "per sample");
+    for(k = 0; k <= CHIPTUNE_CHANNELS; k++) printf("  %-16u %12.1f\n", k, ns[k]);
+    printf("  per filtered voice: %.1f per output sample, %.2f per rendered sample\n"
+           "  (target cycles: Chiptune_GetStats() mix, CHIPTUNE_PROFILE build)\n\n",
+           slope, slope / CHIPTUNE_OVERSAMPLE);
+
+    return 0;
+}
+
+/* Drives channel 0's filter, returns the peak and the last tick's residual */
+static void ring(uint8_t cutoff, uint8_t filter, int32_t *peak, int32_t *residual)
+{
+    uint8_t program[] = {
+        cmdnum('w'), WF_SAW, cmdnum('v'), 0xff, cmdnum('c'), cutoff, cmdnum('q'), filter,
+        cmdnum('t'), DRIVE_TICKS,
+        /* No sample selected: the voice plays zeros into the filter */
+        cmdnum('w'), WF_SAMPLE, cmdnum('t'), SETTLE_TICKS + 2
+    };
+    chiptune_sfx_t fx = { program, sizeof(program) / 2, 0x1 };
+    uint32_t n, start;
+
+    Chiptune_Init();
+    /* Muting channel 0 would silence the effect too */
+    Chiptune_SetMute(0xe);
+    Chiptune_SetSfxBank(&fx, 1);
+    post(CHIPTUNE_EV_SFX, 0, 0, 0x30);
+
+    /* The effect starts at the first tick */
+    for(n = 0; !Chiptune_GetSfxChannels(); n++)
+    {
+        if(n % POLL_FRAMES == 0) Chiptune_Process();
+        Chiptune_AudioCallback();
+    }
+    start = n;
+    *peak = *residual = 0;
+    for(; n < start + SWEEP_FRAMES; n++)
+    {
+        int32_t y;
+
+        if(n % POLL_FRAMES == 0) Chiptune_Process();
+        Chiptune_AudioCallback();
+        y = abs(output());
+        if(y > *peak) *peak = y;
+        if(n >= start + SWEEP_FRAMES - TICK_FRAMES && y > *residual) *residual = y;
+    }
+    if(!Chiptune_GetSfxChannels())
+    {
+        fprintf(stderr, "svfbench: the effect ended early\n");
+        exit(1);
+    }
+}
+
+static int sweep(void)
+{
+    int32_t full, peak, residual, worstpeak = 0, worstresidual = 0;
+    uint32_t runs = 0, failed = 0;
+    uint16_t cutoff;
+    uint8_t res, mode;
+
+    /* A low-pass open at the top passes the saw: the unfiltered scale */
+    ring(0xff, FILTER_LP, &full, &residual);
+
+    for(mode = 1; mode <= FILTER_MODES; mode++)
+    {
+        for(res = 0; res < 16; res++)
+        {
+            for(cutoff = 0; cutoff <= 0x100; cutoff += 8)
+            {
+                uint8_t c = cutoff > 0xff ? 0xff : cutoff;
+
+                ring(c, res << 4 | mode, &peak, &residual);
+                runs++;
+                if(peak > worstpeak) worstpeak = peak;
+                if(residual > worstresidual) worstresidual = residual;
+                if(residual > SETTLE_FLOOR)
+                {
+                    if(!failed) fprintf(stderr, "svfbench: c%02x q%02x still at %d after %u ticks of silence\n",
+                                        c, res << 4 | mode, residual, SETTLE_TICKS);
+                    failed++;
+                }
+            }
+        }
+    }
+
+    printf("stability: %u runs (cutoff points x 16 resonances x 7 modes), %u failed\n", runs, failed);
+    printf("  worst peak %d, %.1fx the open filter's %d; worst residual %d after %u ticks\n\n",
+           worstpeak, (double)worstpeak / full, full, worstresidual, SETTLE_TICKS);
+
+    return failed != 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long seconds = 20;
+
+    if(argc == 3 && !strcmp(argv[1], "-s"))
+    {
+        seconds = strtoul(argv[2], NULL, 0);
+    }
+    if((argc != 1 && argc != 3) || !seconds || seconds > MAX_SECONDS)
+    {
+        fprintf(stderr, "usage: svfbench [-s seconds]\n");
+        return 2;
+    }
+
+    measure(seconds * CHIPTUNE_SAMPLE_RATE);
+
+    return sweep();
+}